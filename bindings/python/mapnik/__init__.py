@@ -361,6 +361,12 @@ def Shapefile(**keywords):
     Optional keyword arguments:
       base -- path prefix (default None)
       encoding -- file encoding (default 'utf-8')
+      generalize -- read simplified geometries at low resolutions from a
+                    <file>.generalized file (default False)
+      generalize_levels -- number of simplified levels (default 8). A
+                    missing or outdated .generalized file is built while
+                    the datasource is created, which reads the whole .shp
+                    once per level, so the first creation can take long
 
     >>> from mapnik import Shapefile, Layer
     >>> shp = Shapefile(base='/home/mapnik/data',file='world_borders') 
@@ -663,6 +669,7 @@ __all__ = [
     'ViewTransform',
     # enums
     'aspect_fix_mode',
+    'label_detector',
     'label_placement',
     'line_cap',
     'line_join',
@@ -671,6 +678,7 @@ __all__ = [
     'horizontal_alignment',
     'justify_alignment',
     'pattern_alignment',
+    'simplify_algorithm',
     # functions
     # datasources
     'Datasource', 'CreateDatasource',
@@ -686,7 +694,7 @@ __all__ = [
     'PathExpression',
     #   load/save/render
     'load_map', 'load_map_from_string', 'save_map', 'save_map_to_string',
-    'render', 'render_tile_to_file', 'render_to_file',
+    'render', 'render_metatile', 'render_tile_to_file', 'render_to_file',
     #   other
     'register_plugins', 'register_fonts',
     'scale_denominator',
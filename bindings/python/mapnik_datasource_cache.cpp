@@ -45,5 +45,9 @@ void export_datasource_cache()
         .staticmethod("register_datasources")
         .def("plugin_names",&datasource_cache::plugin_names)
         .staticmethod("plugin_names")        
+        .def("set_shared_instances",&datasource_cache::set_shared_instances)
+        .staticmethod("set_shared_instances")
+        .def("shared_instances",&datasource_cache::shared_instances)
+        .staticmethod("shared_instances")
         ;
 }
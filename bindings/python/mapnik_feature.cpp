@@ -127,13 +127,12 @@ namespace boost { namespace python {
         static data_type&
         get_item(Container& container, index_type i_)
         {
-            typename Container::iterator i = container.props().find(i_);
-            if (i == container.end())
+            if (!container.has_key(i_))
             {
                 PyErr_SetString(PyExc_KeyError, "Invalid key");
                 throw_error_already_set();
             }
-            return i->second;
+            return container[i_];
         }
             
         static void
@@ -145,25 +144,25 @@ namespace boost { namespace python {
         static void
         delete_item(Container& container, index_type i)
         {
-            container.props().erase(i);
+            container.erase(i);
         }
           
         static size_t
         size(Container& container)
         {
-            return container.props().size();
+            return container.size();
         }
           
         static bool
         contains(Container& container, key_type const& key)
         {
-            return container.props().find(key) != container.end();
+            return container.has_key(key);
         }
             
         static bool
         compare_index(Container& container, index_type a, index_type b)
         {
-            return container.props().key_comp()(a, b);
+            return a < b;
         }
             
         static index_type
@@ -261,7 +260,7 @@ void export_feature()
     implicitly_convertible<UnicodeString,mapnik::value>();
     implicitly_convertible<bool,mapnik::value>();
 
-    std_pair_to_python_converter<std::string const,mapnik::value>();
+    std_pair_to_python_converter<std::string,mapnik::value>();
     to_python_converter<mapnik::value,mapnik_value_to_python>();
     UnicodeString_from_python_str();
    
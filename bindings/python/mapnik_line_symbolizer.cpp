@@ -23,10 +23,12 @@
 
 #include <boost/python.hpp>
 #include <mapnik/line_symbolizer.hpp>
+#include "mapnik_enumeration.hpp"
 
 using mapnik::line_symbolizer;
 using mapnik::stroke;
 using mapnik::color;
+using mapnik::simplify_algorithm_e;
 
 struct line_symbolizer_pickle_suite : boost::python::pickle_suite
 {
@@ -36,11 +38,39 @@ struct line_symbolizer_pickle_suite : boost::python::pickle_suite
         return boost::python::make_tuple(l.get_stroke());
     }
 
+    static  boost::python::tuple
+    getstate(const line_symbolizer& l)
+    {
+        return boost::python::make_tuple(l.get_simplify_tolerance(),l.get_simplify_algorithm());
+    }
+
+    static void
+    setstate (line_symbolizer& l, boost::python::tuple state)
+    {
+        using namespace boost::python;
+        if (len(state) != 2)
+        {
+            PyErr_SetObject(PyExc_ValueError,
+                            ("expected 2-item tuple in call to __setstate__; got %s"
+                             % state).ptr()
+                );
+            throw_error_already_set();
+        }
+
+        l.set_simplify_tolerance(extract<double>(state[0]));
+        l.set_simplify_algorithm(extract<simplify_algorithm_e>(state[1]));
+    }
+
 };
 
 void export_line_symbolizer()
 {
     using namespace boost::python;
+
+    mapnik::enumeration_<simplify_algorithm_e>("simplify_algorithm")
+        .value("RADIAL_DISTANCE",mapnik::RADIAL_DISTANCE)
+        .value("DOUGLAS_PEUCKER",mapnik::DOUGLAS_PEUCKER)
+        ;
     
     class_<line_symbolizer>("LineSymbolizer",
                             init<>("Default LineSymbolizer - 1px solid black"))
@@ -51,5 +81,12 @@ void export_line_symbolizer()
                       (&line_symbolizer::get_stroke,
                        return_value_policy<copy_const_reference>()),
                       &line_symbolizer::set_stroke)
+        .add_property("simplify",
+                      &line_symbolizer::get_simplify_tolerance,
+                      &line_symbolizer::set_simplify_tolerance,
+                      "Vertices closer than this many pixels are dropped, 0 disables")
+        .add_property("simplify_algorithm",
+                      &line_symbolizer::get_simplify_algorithm,
+                      &line_symbolizer::set_simplify_algorithm)
         ;    
 }
@@ -161,6 +161,11 @@ void export_map()
         .value("ADJUST_CANVAS_WIDTH",mapnik::Map::ADJUST_CANVAS_WIDTH)
         .value("ADJUST_CANVAS_HEIGHT", mapnik::Map::ADJUST_CANVAS_HEIGHT)
         ;
+
+    mapnik::enumeration_<mapnik::label_detector_e>("label_detector")
+        .value("QUAD_TREE", mapnik::QUAD_TREE_DETECTOR)
+        .value("GRID", mapnik::GRID_DETECTOR)
+        ;
    
     python_optional<mapnik::color> ();
     class_<std::vector<layer> >("Layers")
@@ -434,6 +439,17 @@ void export_map()
                       ">>> m.buffer_size\n"
                       "2\n"
             )
+
+        .add_property("label_detector",
+                      &Map::label_detector,
+                      &Map::set_label_detector,
+                      "Get/Set the structure labels are checked for collisions with.\n"
+                      "\n"
+                      "Usage:\n"
+                      ">>> m.label_detector\n"
+                      "mapnik._mapnik.label_detector.QUAD_TREE # by default\n"
+                      ">>> m.label_detector = label_detector.GRID\n"
+            )
          
         .add_property("height",
                       &Map::height,
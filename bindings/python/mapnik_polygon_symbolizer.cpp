@@ -26,6 +26,7 @@
 
 using mapnik::polygon_symbolizer;
 using mapnik::color;
+using mapnik::simplify_algorithm_e;
 
 struct polygon_symbolizer_pickle_suite : boost::python::pickle_suite
 {
@@ -38,17 +39,18 @@ struct polygon_symbolizer_pickle_suite : boost::python::pickle_suite
     static  boost::python::tuple
     getstate(const polygon_symbolizer& p)
     {
-        return boost::python::make_tuple(p.get_opacity(),p.get_gamma());
+        return boost::python::make_tuple(p.get_opacity(),p.get_gamma(),
+                                         p.get_simplify_tolerance(),p.get_simplify_algorithm());
     }
 
     static void
     setstate (polygon_symbolizer& p, boost::python::tuple state)
     {
         using namespace boost::python;
-        if (len(state) != 2)
+        if (len(state) != 4)
         {
             PyErr_SetObject(PyExc_ValueError,
-                            ("expected 2-item tuple in call to __setstate__; got %s"
+                            ("expected 4-item tuple in call to __setstate__; got %s"
                              % state).ptr()
                 );
             throw_error_already_set();
@@ -56,6 +58,8 @@ struct polygon_symbolizer_pickle_suite : boost::python::pickle_suite
                 
         p.set_opacity(extract<float>(state[0]));
         p.set_gamma(extract<float>(state[1]));
+        p.set_simplify_tolerance(extract<double>(state[2]));
+        p.set_simplify_algorithm(extract<simplify_algorithm_e>(state[3]));
     }
 
 };
@@ -78,6 +82,13 @@ void export_polygon_symbolizer()
         .add_property("gamma",
                       &polygon_symbolizer::get_gamma,
                       &polygon_symbolizer::set_gamma)
+        .add_property("simplify",
+                      &polygon_symbolizer::get_simplify_tolerance,
+                      &polygon_symbolizer::set_simplify_tolerance,
+                      "Vertices closer than this many pixels are dropped, 0 disables")
+        .add_property("simplify_algorithm",
+                      &polygon_symbolizer::get_simplify_algorithm,
+                      &polygon_symbolizer::set_simplify_algorithm)
         ;    
 
 }
@@ -74,6 +74,7 @@ void export_glyph_symbolizer();
 #include <mapnik/load_map.hpp>
 #include <mapnik/config_error.hpp>
 #include <mapnik/save_map.hpp>
+#include <mapnik/metatile.hpp>
 
 #if defined(HAVE_CAIRO) && defined(HAVE_PYCAIRO)
 #include <pycairo.h>
@@ -179,6 +180,35 @@ void render_tile_to_file(const mapnik::Map& map,
     mapnik::save_to_file(image.data(),file,format);
 }
 
+boost::python::list render_metatile(const mapnik::Map& map,
+                                    const mapnik::box2d<double>& extent,
+                                    unsigned tiles,
+                                    unsigned tile_size,
+                                    const std::string& format,
+                                    double scale_factor)
+{
+    std::vector<std::string> encoded;
+    Py_BEGIN_ALLOW_THREADS
+        try
+        {
+            encoded = mapnik::render_metatile(map,extent,tiles,tile_size,format,scale_factor);
+        }
+        catch (...)
+        {
+            Py_BLOCK_THREADS
+                throw;
+        }
+    Py_END_ALLOW_THREADS
+
+    boost::python::list result;
+    for (std::vector<std::string>::const_iterator itr = encoded.begin(); itr != encoded.end(); ++itr)
+    {
+        result.append(boost::python::object(boost::python::handle<>(
+            PyString_FromStringAndSize(itr->data(), itr->size()))));
+    }
+    return result;
+}
+
 void render_to_file1(const mapnik::Map& map,
                      const std::string& filename,
                      const std::string& format)
@@ -404,6 +434,24 @@ BOOST_PYTHON_MODULE(_mapnik2)
         "\n"
         ); 
 
+    def("render_metatile",&render_metatile,
+        (arg("map"),arg("extent"),arg("tiles"),arg("tile_size"),
+         arg("format")="png",arg("scale_factor")=1.0),
+        "\n"
+        "Render a tiles x tiles block of tiles of tile_size pixels covering\n"
+        "extent in one pass and return the encoded tiles row by row.\n"
+        "extent has to be square, RuntimeError is raised otherwise.\n"
+        "\n"
+        "Usage:\n"
+        ">>> from mapnik import Map, Box2d, render_metatile, load_map\n"
+        ">>> m = Map(256,256)\n"
+        ">>> load_map(m,'mapfile.xml')\n"
+        ">>> tiles = render_metatile(m,Box2d(-180,-180,180,180),4,256,'png')\n"
+        ">>> len(tiles)\n"
+        "16\n"
+        "\n"
+        ); 
+
     
     def("render", &render, render_overloads(
             "\n" 
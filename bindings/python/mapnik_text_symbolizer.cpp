@@ -254,6 +254,9 @@ void export_text_symbolizer()
                       &text_symbolizer::set_minimum_distance)
         .add_property("name",&text_symbolizer::get_name,
                       &text_symbolizer::set_name)
+        .add_property("priority",&text_symbolizer::get_priority,
+                      &text_symbolizer::set_priority,
+                      "Set/get the expression deferred labels are placed in order of (highest first)")
         .add_property("opacity",
                       &text_symbolizer::get_text_opacity,
                       &text_symbolizer::set_text_opacity,
@@ -167,9 +167,8 @@ void MapWidget::mousePressEvent(QMouseEvent* e)
                   feature_ptr feat  = fs->next();
                   if (feat)   
                   {
-                     std::map<std::string,mapnik::value> const& props = feat->props();
-                     std::map<std::string,mapnik::value>::const_iterator itr=props.begin();
-                     for (; itr!=props.end();++itr)
+                     mapnik::Feature::iterator itr=feat->begin();
+                     for (; itr!=feat->end();++itr)
                      {
                         if (itr->second.to_string().length() > 0)
                         {
@@ -36,10 +36,41 @@
 // boost
 #include <boost/utility.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+// stl
+#include <vector>
    
 namespace mapnik {
    
 struct rasterizer;
+
+/** State of the AGG renderer that is worth keeping between renders:
+  * the FreeType library with the faces loaded so far and the
+  * rasterizer with its cell blocks. A tile server can keep one context
+  * per thread and pass it to each agg_renderer it creates. A context
+  * must not be used by two renderers at the same time.
+  */
+class MAPNIK_DECL agg_render_context : private boost::noncopyable
+{
+public:
+    agg_render_context();
+    ~agg_render_context();
+
+    face_manager<freetype_engine> & font_manager()
+    {
+        return font_manager_;
+    }
+
+    rasterizer & get_rasterizer()
+    {
+        return *ras_ptr_;
+    }
+
+private:
+    freetype_engine font_engine_;
+    face_manager<freetype_engine> font_manager_;
+    boost::scoped_ptr<rasterizer> ras_ptr_;
+};
    
 template <typename T>
 class MAPNIK_DECL agg_renderer : public feature_style_processor<agg_renderer<T> >,
@@ -48,6 +79,10 @@ class MAPNIK_DECL agg_renderer : public feature_style_processor<agg_renderer<T>
      
 public:
     agg_renderer(Map const& m, T & pixmap, double scale_factor=1.0, unsigned offset_x=0, unsigned offset_y=0);
+    /** Renders with the fonts and rasterizer of a long lived context
+      * instead of setting up new ones.
+      */
+    agg_renderer(Map const& m, T & pixmap, agg_render_context & ctx, double scale_factor=1.0, unsigned offset_x=0, unsigned offset_y=0);
     ~agg_renderer();
     void start_map_processing(Map const& map);
     void end_map_processing(Map const& map);
@@ -95,15 +130,38 @@ public:
     };
 
 private:
+    /** A text placement held back until the end of the layer, see
+      * text_symbolizer::set_priority. Keeps everything needed to
+      * render it, but not the feature.
+      */
+    struct deferred_label
+    {
+        text_symbolizer const* sym;
+        face_set_ptr faces;
+        boost::shared_ptr<string_info> info;
+        boost::shared_ptr<placement> placements;
+        double priority;
+    };
+
+    void setup(Map const& m);
+    void render_deferred_labels();
+
+    // only set when no context was passed in
+    boost::scoped_ptr<agg_render_context> own_context_;
     T & pixmap_;
     unsigned width_;
     unsigned height_;
     double scale_factor_;
     CoordTransform t_;
-    freetype_engine font_engine_;
-    face_manager<freetype_engine> font_manager_;
+    face_manager<freetype_engine> & font_manager_;
     label_collision_detector4 detector_;
-    boost::scoped_ptr<rasterizer> ras_ptr;
+    // placements of deferred labels are found against this detector,
+    // only avoiding each other, and collision tested at the layer end.
+    // It is cleared for every feature, so it is always a grid, whose
+    // clear() only visits the cells the previous feature used
+    label_collision_detector4 scratch_detector_;
+    std::vector<deferred_label> deferred_labels_;
+    rasterizer * ras_ptr;
 };
 }
 
@@ -0,0 +1,231 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_ARENA_HPP
+#define MAPNIK_ARENA_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+// boost
+#include <boost/utility.hpp>
+// stl
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace mapnik
+{
+
+/** Bump allocator releasing everything it handed out at once.
+  *
+  * Memory is carved from large chunks, deallocation is a no-op and
+  * release() (or the destructor) frees all chunks. Objects allocated
+  * from an arena must be destroyed before it is released. An arena is
+  * not synchronized, only one thread may allocate from it at a time.
+  */
+class MAPNIK_DECL arena : private boost::noncopyable
+{
+public:
+    enum { alignment = 16 };
+
+    explicit arena(std::size_t chunk_size = 65536);
+    ~arena();
+
+    void * allocate(std::size_t size)
+    {
+        size = (size + alignment - 1) & ~std::size_t(alignment - 1);
+        if (size > static_cast<std::size_t>(end_ - pos_))
+        {
+            return allocate_chunk(size);
+        }
+        void * p = pos_;
+        pos_ += size;
+        used_ += size;
+        return p;
+    }
+
+    /** Frees all memory at once. */
+    void release();
+
+    /** Bytes handed out since construction or the last release. */
+    std::size_t used() const;
+
+    /** The arena new allocations of this thread come from, 0 if none. */
+    static arena * current();
+
+private:
+    friend class arena_scope;
+    static void set_current(arena * a);
+    void * allocate_chunk(std::size_t size);
+
+    std::size_t chunk_size_;
+    std::vector<char*> chunks_;
+    char * pos_;
+    char * end_;
+    std::size_t used_;
+};
+
+/** Makes an arena the current one of this thread for its lifetime.
+  * Scopes nest; the previous arena is restored on destruction.
+  */
+class MAPNIK_DECL arena_scope : private boost::noncopyable
+{
+public:
+    explicit arena_scope(arena * a)
+        : previous_(arena::current())
+    {
+        arena::set_current(a);
+    }
+
+    ~arena_scope()
+    {
+        arena::set_current(previous_);
+    }
+
+private:
+    arena * previous_;
+};
+
+/** Allocates from the current arena if there is one, from the heap
+  * otherwise. Objects remember where they came from so arena_delete
+  * works whether or not an arena is current when they are freed.
+  */
+inline void * arena_new(std::size_t size)
+{
+    arena * a = arena::current();
+    char * p;
+    if (a)
+    {
+        p = static_cast<char*>(a->allocate(size + arena::alignment));
+        p[0] = 1;
+    }
+    else
+    {
+        p = static_cast<char*>(::operator new(size + arena::alignment));
+        p[0] = 0;
+    }
+    return p + arena::alignment;
+}
+
+inline void arena_delete(void * ptr)
+{
+    if (!ptr) return;
+    char * p = static_cast<char*>(ptr) - arena::alignment;
+    if (p[0] == 0) ::operator delete(p);
+}
+
+/** Class level operator new/delete for types that should come from
+  * the current arena when one is installed.
+  */
+#define MAPNIK_ARENA_ALLOCATED                                     \
+    static void * operator new(std::size_t size)                    \
+    {                                                               \
+        return mapnik::arena_new(size);                             \
+    }                                                               \
+    static void operator delete(void * p)                           \
+    {                                                               \
+        mapnik::arena_delete(p);                                    \
+    }
+
+/** Standard allocator bound to the arena current at its construction,
+  * or to the heap when there is none.
+  */
+template <typename T>
+class arena_allocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef T const* const_pointer;
+    typedef T& reference;
+    typedef T const& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef arena_allocator<U> other;
+    };
+
+    arena_allocator()
+        : arena_(arena::current()) {}
+
+    template <typename U>
+    arena_allocator(arena_allocator<U> const& other)
+        : arena_(other.get_arena()) {}
+
+    pointer allocate(size_type n, void const* = 0)
+    {
+        if (arena_) return static_cast<pointer>(arena_->allocate(n * sizeof(T)));
+        return static_cast<pointer>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(pointer p, size_type)
+    {
+        if (!arena_) ::operator delete(p);
+    }
+
+    void construct(pointer p, T const& val)
+    {
+        new (static_cast<void*>(p)) T(val);
+    }
+
+    void destroy(pointer p)
+    {
+        p->~T();
+    }
+
+    pointer address(reference x) const { return &x; }
+    const_pointer address(const_reference x) const { return &x; }
+
+    size_type max_size() const
+    {
+        return size_type(-1) / sizeof(T);
+    }
+
+    arena * get_arena() const
+    {
+        return arena_;
+    }
+
+    template <typename U>
+    bool operator==(arena_allocator<U> const& other) const
+    {
+        return arena_ == other.get_arena();
+    }
+
+    template <typename U>
+    bool operator!=(arena_allocator<U> const& other) const
+    {
+        return arena_ != other.get_arena();
+    }
+
+private:
+    arena * arena_;
+};
+
+}
+
+#endif // MAPNIK_ARENA_HPP
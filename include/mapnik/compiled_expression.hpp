@@ -0,0 +1,221 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_COMPILED_EXPRESSION_HPP
+#define MAPNIK_COMPILED_EXPRESSION_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/expression_node.hpp>
+#include <mapnik/filter_factory.hpp>
+// boost
+#include <boost/shared_ptr.hpp>
+#include <boost/regex.hpp>
+#include <boost/regex/icu.hpp>
+// stl
+#include <vector>
+#include <string>
+
+namespace mapnik
+{
+
+/** An expression flattened into a postfix program.
+  *
+  * Attribute names are resolved to slots of the feature context the
+  * first time a feature of that context is evaluated, after that an
+  * attribute is a vector index instead of a map lookup. Featuresets
+  * share one context between their features so this happens once per
+  * query. Gives the same results as evaluate<Feature,value_type>.
+  *
+  * Evaluation keeps state, use one compiled_expression per thread.
+  */
+class MAPNIK_DECL compiled_expression
+{
+public:
+    enum opcode
+    {
+        push_value,
+        push_attribute,
+        add,
+        sub,
+        mult,
+        div,
+        mod,
+        less,
+        less_equal,
+        greater,
+        greater_equal,
+        equal_to,
+        not_equal_to,
+        logical_not,
+        and_jump,   // short circuit of 'and', argument is the jump target
+        or_jump,    // short circuit of 'or', argument is the jump target
+        to_bool,
+        regex_match,
+        regex_replace
+    };
+
+    struct instruction
+    {
+        instruction(opcode o, std::size_t a)
+            : op(o), arg(a) {}
+        opcode op;
+        std::size_t arg;
+    };
+
+    explicit compiled_expression(expression_ptr const& expr);
+
+    value_type evaluate(Feature const& f) const
+    {
+        context_ptr const& ctx = f.get_context();
+        if (ctx != ctx_ || ctx->size() != bound_size_)
+        {
+            bind(ctx);
+        }
+        stack_.clear();
+        std::size_t pc = 0;
+        std::size_t const size = code_.size();
+        while (pc < size)
+        {
+            instruction const& ins = code_[pc++];
+            switch (ins.op)
+            {
+            case push_value:
+                stack_.push_back(values_[ins.arg]);
+                break;
+            case push_attribute:
+            {
+                std::size_t slot = slots_[ins.arg];
+                stack_.push_back(slot == unbound ? value_type() : f.get(slot));
+                break;
+            }
+            case add:
+                binary<std::plus<value_type> >();
+                break;
+            case sub:
+                binary<std::minus<value_type> >();
+                break;
+            case mult:
+                binary<std::multiplies<value_type> >();
+                break;
+            case div:
+                binary<std::divides<value_type> >();
+                break;
+            case mod:
+                binary<std::modulus<value_type> >();
+                break;
+            case less:
+                binary<std::less<value_type> >();
+                break;
+            case less_equal:
+                binary<std::less_equal<value_type> >();
+                break;
+            case greater:
+                binary<std::greater<value_type> >();
+                break;
+            case greater_equal:
+                binary<std::greater_equal<value_type> >();
+                break;
+            case equal_to:
+                binary<std::equal_to<value_type> >();
+                break;
+            case not_equal_to:
+                binary<std::not_equal_to<value_type> >();
+                break;
+            case logical_not:
+                stack_.back() = !stack_.back().to_bool();
+                break;
+            case and_jump:
+                if (!stack_.back().to_bool())
+                {
+                    stack_.back() = false;
+                    pc = ins.arg;
+                }
+                else
+                {
+                    stack_.pop_back();
+                }
+                break;
+            case or_jump:
+                if (stack_.back().to_bool())
+                {
+                    stack_.back() = true;
+                    pc = ins.arg;
+                }
+                else
+                {
+                    stack_.pop_back();
+                }
+                break;
+            case to_bool:
+                stack_.back() = stack_.back().to_bool();
+                break;
+            case regex_match:
+                stack_.back() = boost::u32regex_match(stack_.back().to_unicode(),
+                                                      match_nodes_[ins.arg]->pattern);
+                break;
+            case regex_replace:
+            {
+                regex_replace_node const* node = replace_nodes_[ins.arg];
+                stack_.back() = boost::u32regex_replace(stack_.back().to_unicode(),
+                                                        node->pattern, node->format);
+                break;
+            }
+            }
+        }
+        return stack_.back();
+    }
+
+private:
+    friend struct expression_compiler;
+    static const std::size_t unbound = static_cast<std::size_t>(-1);
+
+    template <typename Op>
+    void binary() const
+    {
+        Op operation;
+        value_type right = stack_.back();
+        stack_.pop_back();
+        stack_.back() = operation(stack_.back(), right);
+    }
+
+    void bind(context_ptr const& ctx) const;
+
+    expression_ptr expr_;
+    std::vector<instruction> code_;
+    std::vector<value_type> values_;
+    std::vector<std::string> names_;
+    std::vector<regex_match_node const*> match_nodes_;
+    std::vector<regex_replace_node const*> replace_nodes_;
+    // bound state
+    mutable context_ptr ctx_;
+    mutable std::size_t bound_size_;
+    mutable std::vector<std::size_t> slots_;
+    mutable std::vector<value_type> stack_;
+};
+
+}
+
+#endif // MAPNIK_COMPILED_EXPRESSION_HPP
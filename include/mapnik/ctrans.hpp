@@ -26,10 +26,12 @@
 #define CTRANS_HPP
 
 #include <algorithm>
+#include <vector>
 
 #include <mapnik/box2d.hpp>
 #include <mapnik/coord_array.hpp>
 #include <mapnik/proj_transform.hpp>
+#include <mapnik/vertex.hpp>
 
 namespace mapnik {
 typedef coord_array<coord2d> CoordinateArray;
@@ -37,26 +39,35 @@ typedef coord_array<coord2d> CoordinateArray;
 template <typename Transform,typename Geometry>
 struct MAPNIK_DECL coord_transform
 {
-    coord_transform(Transform const& t, Geometry& geom)
-        : t_(t), geom_(geom) {}
+    coord_transform(Transform const& t, Geometry const& geom)
+        : t_(t), geom_(geom), pos_(0) {}
         
     unsigned  vertex(double *x , double *y) const
     {
-        unsigned command = geom_.vertex(x,y);
+        unsigned command = geom_.get_vertex(pos_++,x,y);
         t_.forward(x,y);
         return command;
     }
         
-    void rewind (unsigned pos)
+    void rewind (unsigned)
     {
-        geom_.rewind(pos);
+        pos_ = 0;
     }
         
 private:
     Transform const& t_;
-    Geometry& geom_;
+    Geometry const& geom_;
+    mutable unsigned pos_;
 };
 
+/** Transforms geometry vertices into screen coordinates.
+  *
+  * feature_style_processor reprojects vector features once before
+  * they reach the symbolizers, so prj_trans is usually an identity
+  * transform and vertices are read straight from the geometry. For
+  * other callers all vertices are reprojected with a single batched
+  * proj_transform call on first access.
+  */
 template <typename Transform,typename Geometry>
 struct MAPNIK_DECL coord_transform2
 {
@@ -65,20 +76,29 @@ struct MAPNIK_DECL coord_transform2
                      proj_transform const& prj_trans)
         : t_(t), 
         geom_(geom), 
-        prj_trans_(prj_trans)  {}
+        prj_trans_(prj_trans),
+        pos_(0),
+        projected_(false) {}
         
     unsigned  vertex(double * x , double  * y) const
     {
-        unsigned command = geom_.vertex(x,y);
-        double z=0;
-        prj_trans_.backward(*x,*y,z);
+        if (prj_trans_.equal())
+        {
+            unsigned command = geom_.get_vertex(pos_++,x,y);
+            t_.forward(x,y);
+            return command;
+        }
+        if (!projected_) project();
+        if (pos_ >= cmds_.size()) return SEG_END;
+        *x = xs_[pos_];
+        *y = ys_[pos_];
         t_.forward(x,y);
-        return command;
+        return cmds_[pos_++];
     }
         
-    void rewind (unsigned pos)
+    void rewind (unsigned)
     {
-        geom_.rewind(pos);
+        pos_ = 0;
     }
 
     Geometry const& geom() const
@@ -87,9 +107,32 @@ struct MAPNIK_DECL coord_transform2
     }
         
 private:
+    void project() const
+    {
+        unsigned size = geom_.num_points();
+        xs_.resize(size);
+        ys_.resize(size);
+        cmds_.resize(size);
+        for (unsigned i = 0; i < size; ++i)
+        {
+            cmds_[i] = geom_.get_vertex(i,&xs_[i],&ys_[i]);
+        }
+        if (size > 0)
+        {
+            prj_trans_.backward(&xs_[0],&ys_[0],0,size);
+        }
+        pos_ = 0;
+        projected_ = true;
+    }
+
     Transform const& t_;
     Geometry const& geom_;
     proj_transform const& prj_trans_;
+    mutable std::vector<double> xs_;
+    mutable std::vector<double> ys_;
+    mutable std::vector<unsigned> cmds_;
+    mutable unsigned pos_;
+    mutable bool projected_;
 };
     
 template <typename Transform,typename Geometry>
@@ -102,11 +145,12 @@ struct MAPNIK_DECL coord_transform3
         : t_(t), 
         geom_(geom), 
         prj_trans_(prj_trans),
-        dx_(dx), dy_(dy) {}
+        dx_(dx), dy_(dy),
+        pos_(0) {}
       
     unsigned  vertex(double * x , double  * y) const
     {
-        unsigned command = geom_.vertex(x,y);
+        unsigned command = geom_.get_vertex(pos_++,x,y);
         double z=0;
         prj_trans_.backward(*x,*y,z);
         t_.forward(x,y);
@@ -115,9 +159,9 @@ struct MAPNIK_DECL coord_transform3
         return command;
     }
       
-    void rewind (unsigned pos)
+    void rewind (unsigned)
     {
-        geom_.rewind(pos);
+        pos_ = 0;
     }
       
 private:
@@ -126,6 +170,7 @@ private:
     proj_transform const& prj_trans_;
     int dx_;
     int dy_;
+    mutable unsigned pos_;
 };
    
 class CoordTransform
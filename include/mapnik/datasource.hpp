@@ -92,6 +92,19 @@ public:
      * @return The type of the datasource (Vector or Raster)
      */
     virtual int type() const=0;
+
+    /*!
+     * @brief Whether features() may be called from several threads at once
+     *
+     * datasource_cache only shares instances of thread safe datasources
+     * between callers unless sharing is asked for explicitly.
+     *
+     * @return false unless the datasource overrides it
+     */
+    virtual bool thread_safe() const
+    {
+        return false;
+    }
         
     virtual featureset_ptr features(const query& q) const=0;
     virtual featureset_ptr features_at_point(coord2d const& pt) const=0;
@@ -32,6 +32,7 @@
 #include <mapnik/datasource.hpp>
 // boost
 #include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
 // stl
 #include <map>
 
@@ -49,11 +50,24 @@ private:
     static bool registered_;
     static bool insert(const std::string&  name,const lt_dlhandle module);
     static std::vector<std::string> plugin_directories_;
+    static bool shared_instances_;
+    static std::map<param_map,boost::weak_ptr<datasource> > instances_;
+    static datasource_ptr create_instance(parameters const& params);
 public:
     static std::vector<std::string> plugin_names();
     static std::string plugin_directories();    
     static void register_datasources(const std::string& path);
     static boost::shared_ptr<datasource> create(parameters const& params);
+    /** When enabled, create() hands out one instance per distinct set of
+     *  parameters for as long as any caller still holds it, instead of
+     *  opening the same data again for every Map and thread. Only
+     *  datasources whose thread_safe() is true are shared this way.
+     *  Individual datasources can opt in or out with the boolean
+     *  'shared_instance' parameter, which also shares datasources that
+     *  are not thread safe; those must then only be used by one thread.
+     */
+    static void set_shared_instances(bool shared);
+    static bool shared_instances();
 };
 }
 
@@ -28,54 +28,353 @@
 #include <mapnik/value.hpp>
 #include <mapnik/geometry.hpp>
 #include <mapnik/raster.hpp>
+#include <mapnik/arena.hpp>
 
 // boost
-#include <boost/version.hpp>
-#if BOOST_VERSION >= 104000
-#include <boost/property_map/property_map.hpp>
-#else
-#include <boost/property_map.hpp>
-#endif
-
 #include <boost/utility.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#endif
 // stl
 #include <map>
+#include <vector>
+#include <sstream>
 
 namespace mapnik {
 typedef boost::shared_ptr<raster> raster_ptr;    
-typedef boost::associative_property_map<
-std::map<std::string,value
-         > > properties;
-   
+
+/** Maps attribute names to slots in the value vector of a feature.
+  * A featureset usually creates one context for all features it
+  * returns, so the name -> index map exists once per featureset
+  * and every feature only carries a flat std::vector<value>.
+  */
+class context : private boost::noncopyable
+{
+public:
+    typedef std::map<std::string,std::size_t> map_type;
+    typedef map_type::const_iterator iterator;
+    typedef map_type::size_type size_type;
+
+    context() {}
+
+    /** Returns the slot of name, adding it if it is not yet known. */
+    std::size_t push(std::string const& name)
+    {
+        map_type::const_iterator itr = mapping_.find(name);
+        if (itr != mapping_.end()) return itr->second;
+        std::size_t index = mapping_.size();
+        mapping_.insert(std::make_pair(name,index));
+        return index;
+    }
+
+    iterator find(std::string const& name) const
+    {
+        return mapping_.find(name);
+    }
+
+    iterator begin() const
+    {
+        return mapping_.begin();
+    }
+
+    iterator end() const
+    {
+        return mapping_.end();
+    }
+
+    size_type size() const
+    {
+        return mapping_.size();
+    }
+
+private:
+    map_type mapping_;
+};
+
+typedef boost::shared_ptr<context> context_ptr;
+
+/** Decodes attributes of a feature the first time they are read. This
+  * lets a datasource hand out features pointing at their raw record
+  * instead of decoding attributes that filters and labels may never
+  * look at. One instance is usually shared by all features of a
+  * featureset and has to keep the records it decodes from alive.
+  *
+  * Features call decode() with the mutex of the instance held, so
+  * reading a feature from several threads is safe and decoders may use
+  * state that is not thread safe, such as a transcoder.
+  */
+class lazy_attributes : private boost::noncopyable
+{
+public:
+    virtual ~lazy_attributes() {}
+    /** Decodes the attribute in slot index of record into v. */
+    virtual void decode(std::size_t index, const char* record, value & v) const = 0;
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex & mutex() const
+    {
+        return mutex_;
+    }
+private:
+    mutable boost::mutex mutex_;
+#endif
+};
+
+typedef boost::shared_ptr<lazy_attributes> lazy_attributes_ptr;
+
+/** Iterates the (name, value) pairs of a feature in name order,
+  * skipping attributes that are known to the context but not set.
+  */
+template <typename Feature>
+class feature_kv_iterator
+    : public boost::iterator_facade<feature_kv_iterator<Feature>,
+                                    std::pair<std::string,value> const,
+                                    boost::forward_traversal_tag,
+                                    std::pair<std::string,value> const>
+{
+public:
+    feature_kv_iterator(Feature const& f, context::iterator itr)
+        : f_(&f),
+          itr_(itr)
+    {
+        skip_unset();
+    }
+
+private:
+    friend class boost::iterator_core_access;
+
+    void increment()
+    {
+        ++itr_;
+        skip_unset();
+    }
+
+    bool equal(feature_kv_iterator const& other) const
+    {
+        return itr_ == other.itr_;
+    }
+
+    std::pair<std::string,value> const dereference() const
+    {
+        return std::make_pair(itr_->first, f_->get(itr_->second));
+    }
+
+    void skip_unset()
+    {
+        context::iterator end = f_->get_context()->end();
+        while (itr_ != end && f_->get(itr_->second).is_null()) ++itr_;
+    }
+
+    Feature const* f_;
+    context::iterator itr_;
+};
+
 template <typename T1,typename T2>
-struct feature : public properties,
-                 private boost::noncopyable
+struct feature : private boost::noncopyable
 {
 public:
     typedef T1 geometry_type;
     typedef T2 raster_type;
-    typedef std::map<std::string,value>::value_type value_type;
-    typedef std::map<std::string,value>::size_type size_type;
-    typedef std::map<std::string,value>::difference_type difference_type;
+    typedef std::string key_type;
+    typedef std::pair<std::string,value> value_type;
+    typedef std::vector<value>::size_type size_type;
+    typedef std::vector<value>::difference_type difference_type;
+    typedef feature_kv_iterator<feature> iterator;
+    typedef std::vector<value,arena_allocator<value> > data_type;
+    typedef boost::ptr_vector<geometry_type,
+                              boost::heap_clone_allocator,
+                              arena_allocator<void*> > geometry_container;
        
 private:
     int id_;
-    boost::ptr_vector<geometry_type> geom_cont_;
+    geometry_container geom_cont_;
     raster_type   raster_;
-    std::map<std::string,value> props_;
+    context_ptr ctx_;
+    mutable data_type data_;
+    lazy_attributes_ptr lazy_;
+    const char* lazy_record_;
+    mutable boost::uint64_t lazy_slots_;
+    static const value null_value_;
+
+    /** Whether any of the slots may still be lazy. Decoding stores the
+      * values before it clears their bits, so a clear bit can be read
+      * without taking the lock of the decoder.
+      */
+    bool is_lazy(boost::uint64_t slots) const
+    {
+#if defined(MAPNIK_THREADSAFE) && defined(__GNUC__)
+        return (__atomic_load_n(&lazy_slots_, __ATOMIC_ACQUIRE) & slots) != 0;
+#elif defined(MAPNIK_THREADSAFE)
+        // without atomic loads decode_lazy() checks under the lock
+        return true;
+#else
+        return (lazy_slots_ & slots) != 0;
+#endif
+    }
+
+    /** Decodes those of the slots still lazy. data_ already covers all
+      * lazy slots, so concurrent readers never see it reallocated.
+      */
+    void decode_lazy(boost::uint64_t slots) const
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(lazy_->mutex());
+#endif
+        slots &= lazy_slots_;
+        boost::uint64_t remaining = lazy_slots_ & ~slots;
+        for (std::size_t index = 0; slots; ++index, slots >>= 1)
+        {
+            if (slots & 1) lazy_->decode(index, lazy_record_, data_[index]);
+        }
+#if defined(MAPNIK_THREADSAFE) && defined(__GNUC__)
+        __atomic_store_n(&lazy_slots_, remaining, __ATOMIC_RELEASE);
+#else
+        lazy_slots_ = remaining;
+#endif
+    }
+
+    void drop_lazy(std::size_t index)
+    {
+        if (index < max_lazy_slots) lazy_slots_ &= ~(boost::uint64_t(1) << index);
+    }
 public:
-    typedef std::map<std::string,value>::iterator iterator;
+    MAPNIK_ARENA_ALLOCATED
+
+    /** Only attributes in the first max_lazy_slots slots can be lazy. */
+    static const std::size_t max_lazy_slots = 64;
+
+    /** Creates a feature with its own context. */
     explicit feature(int id)
-        : properties(props_),
-          id_(id),
+        : id_(id),
+          geom_cont_(),
+          raster_(),
+          ctx_(new context),
+          data_(),
+          lazy_record_(0),
+          lazy_slots_(0) {}
+
+    /** Creates a feature sharing the attribute layout of ctx. */
+    feature(context_ptr const& ctx, int id)
+        : id_(id),
           geom_cont_(),
-          raster_() {}
+          raster_(),
+          ctx_(ctx),
+          data_(ctx->size()),
+          lazy_record_(0),
+          lazy_slots_(0) {}
        
     int id() const 
     {
         return id_;
     }
+
+    context_ptr const& get_context() const
+    {
+        return ctx_;
+    }
+
+    void put(std::string const& key, value const& val)
+    {
+        (*this)[key] = val;
+    }
+
+    /** Returns the attribute for assignment, adding it to the context if
+      * needed. A lazy attribute is dropped instead of decoded, read it
+      * through a const feature to get its value.
+      */
+    value& operator[](std::string const& key)
+    {
+        std::size_t index = ctx_->push(key);
+        drop_lazy(index);
+        if (index >= data_.size()) data_.resize(ctx_->size());
+        return data_[index];
+    }
+
+    /** Defers the attributes in the slots set in the slots bit mask: they
+      * are decoded from record by decoder when first read.
+      */
+    void set_lazy_attributes(lazy_attributes_ptr const& decoder,
+                             const char* record,
+                             boost::uint64_t slots)
+    {
+        if (data_.size() < ctx_->size()) data_.resize(ctx_->size());
+        lazy_ = decoder;
+        lazy_record_ = record;
+        lazy_slots_ = slots;
+    }
+
+    /** Copies the attributes and the raster of other, which has to share
+      * the context of this feature. Lazy attributes are not decoded.
+      */
+    void copy_attributes(feature const& other)
+    {
+        raster_ = other.raster_;
+        lazy_ = other.lazy_;
+        lazy_record_ = other.lazy_record_;
+        if (!lazy_)
+        {
+            data_.assign(other.data_.begin(), other.data_.end());
+            return;
+        }
+        // other may be decoding on another thread
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(lazy_->mutex());
+#endif
+        data_.assign(other.data_.begin(), other.data_.end());
+        lazy_slots_ = other.lazy_slots_;
+    }
+
+    /** Returns the attribute or a null value if it is not set. */
+    value const& operator[](std::string const& key) const
+    {
+        context::iterator itr = ctx_->find(key);
+        if (itr == ctx_->end()) return null_value_;
+        return get(itr->second);
+    }
+
+    /** Returns the attribute in slot index of the context. */
+    value const& get(std::size_t index) const
+    {
+        if (lazy_ && index < max_lazy_slots)
+        {
+            boost::uint64_t slot = boost::uint64_t(1) << index;
+            if (is_lazy(slot)) decode_lazy(slot);
+        }
+        if (index < data_.size()) return data_[index];
+        return null_value_;
+    }
+
+    bool has_key(std::string const& key) const
+    {
+        return !(*this)[key].is_null();
+    }
+
+    /** Unsets the attribute, its slot stays in the context. */
+    void erase(std::string const& key)
+    {
+        context::iterator itr = ctx_->find(key);
+        if (itr == ctx_->end()) return;
+        drop_lazy(itr->second);
+        if (itr->second < data_.size())
+        {
+            data_[itr->second] = value();
+        }
+    }
+
+    /** Number of attributes set on this feature. */
+    size_type size() const
+    {
+        if (lazy_ && is_lazy(~boost::uint64_t(0))) decode_lazy(~boost::uint64_t(0));
+        size_type count = 0;
+        for (typename data_type::const_iterator itr = data_.begin();
+             itr != data_.end(); ++itr)
+        {
+            if (!itr->is_null()) ++count;
+        }
+        return count;
+    }
        
     void add_geometry(geometry_type * geom)
     {
@@ -125,33 +424,22 @@ public:
     {
         raster_=raster;
     }
-       
-    std::map<std::string,value> const& props() const 
-    {
-        return props_;
-    }
-       
-    std::map<std::string,value>& props() 
-    {
-        return props_;
-    }
     
-    iterator begin()
+    iterator begin() const
     {
-        return props_.begin();
+        return iterator(*this, ctx_->begin());
     }
        
-    iterator end()
+    iterator end() const
     {
-        return props_.end();
+        return iterator(*this, ctx_->end());
     }
        
     std::string to_string() const
     {
         std::stringstream ss;
         ss << "feature (" << std::endl;
-        for (std::map<std::string,value>::const_iterator itr=props_.begin();
-             itr != props_.end();++itr)
+        for (iterator itr = begin(); itr != end(); ++itr)
         {
             ss << "  " << itr->first  << ":" <<  itr->second << std::endl;
         }
@@ -159,6 +447,9 @@ public:
         return ss.str();
     }
 };
+
+template <typename T1,typename T2>
+const value feature<T1,T2>::null_value_;
    
 typedef feature<geometry2d,raster_ptr> Feature;
    
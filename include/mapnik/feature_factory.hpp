@@ -35,6 +35,11 @@ struct feature_factory
     {
         return new Feature(fid);
     }
+
+    static Feature* create (context_ptr const& ctx, int fid)
+    {
+        return new Feature(ctx,fid);
+    }
 }; 
 }
 
@@ -32,18 +32,36 @@
 #include <mapnik/map.hpp>
 #include <mapnik/attribute_collector.hpp>
 #include <mapnik/expression_evaluator.hpp>
+#include <mapnik/compiled_expression.hpp>
+#include <mapnik/filter_dispatch.hpp>
 #include <mapnik/utils.hpp>
 #include <mapnik/projection.hpp>
 #include <mapnik/scale_denominator.hpp>
 #include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/prefetched_featureset.hpp>
+#include <mapnik/arena.hpp>
 
 #ifdef MAPNIK_DEBUG
 //#include <mapnik/wall_clock_timer.hpp>
 #endif
 // boost
 #include <boost/foreach.hpp>
+#include <boost/optional.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#endif
 //stl
 #include <vector>
+#include <map>
+#include <deque>
+#include <set>
+#include <algorithm>
 
 namespace mapnik
 {     
@@ -76,10 +94,277 @@ class feature_style_processor
         Feature const& f_;
         proj_transform const& prj_trans_;
     };
+
+#ifdef MAPNIK_THREADSAFE
+    class fetch_queue;
+#endif
+
+    /** Everything needed to query and symbolize a single layer.
+      * Preparing it is cheap, so the datasource query can be issued
+      * ahead of symbolization (see set_prefetch_threads).
+      */
+    struct layer_rendering_material : private boost::noncopyable
+    {
+        explicit layer_rendering_material(layer const& lay)
+            : lay_(lay),
+              prefetched_(false)
+#ifdef MAPNIK_THREADSAFE
+            , queued_(false),
+              pending_(false),
+              next_(0),
+              queue_(0)
+#endif
+        {}
+
+        featureset_ptr features(query const& q)
+        {
+#ifdef MAPNIK_THREADSAFE
+            boost::mutex::scoped_lock lock(mutex_);
+            if (queued_)
+            {
+                // no worker has started on the layer, rendering does not
+                // wait for one but queries the datasource itself
+                queued_ = false;
+                lock.unlock();
+                return ds_->features(q);
+            }
+            while (pending_) cond_.wait(lock);
+#endif
+            if (prefetched_)
+            {
+                // the prefetched featureset can only be consumed once
+                prefetched_ = false;
+                featureset_ptr fs = fs_;
+                fs_.reset();
+                return fs;
+            }
+            return ds_->features(q);
+        }
+
+#ifdef MAPNIK_THREADSAFE
+        /** Queries the datasource unless rendering got to the layer
+          * first, never waits for the rendering thread.
+          */
+        void fetch(unsigned page_size)
+        {
+            {
+                boost::mutex::scoped_lock lock(mutex_);
+                if (!queued_) return;
+                queued_ = false;
+                pending_ = true;
+            }
+            featureset_ptr fs;
+            bool ok = false;
+            // features read ahead come from the layer arena as well
+            arena_scope scope(arena_.get());
+            try
+            {
+                fs = ds_->features(*q_);
+                if (fs) fs.reset(new prefetched_featureset(fs,page_size));
+                ok = true;
+            }
+            catch (...)
+            {
+                // re-issued from the rendering thread which reports the error
+                fs.reset();
+            }
+            boost::mutex::scoped_lock lock(mutex_);
+            fs_ = fs;
+            prefetched_ = ok;
+            pending_ = false;
+            cond_.notify_all();
+        }
+
+        /** Called once the layer is rendered or abandoned: waits for a
+          * fetch still running and drops features it read ahead, so that
+          * nothing uses the layer arena once it is released. The next
+          * layer on the same datasource can then be fetched.
+          */
+        void finish()
+        {
+            {
+                boost::mutex::scoped_lock lock(mutex_);
+                queued_ = false;
+                while (pending_) cond_.wait(lock);
+                fs_.reset();
+                prefetched_ = false;
+            }
+            if (next_) queue_->ready(*next_);
+        }
+#endif
+        
+        layer const& lay_;
+        datasource_ptr ds_;
+        boost::scoped_ptr<projection> proj1_;
+        boost::optional<query> q_;
+        std::vector<feature_type_style*> active_styles_;
+        // declared before fs_ so that it is destroyed last
+        boost::scoped_ptr<arena> arena_;
+        featureset_ptr fs_;
+        bool prefetched_;
+#ifdef MAPNIK_THREADSAFE
+        // to be fetched, no thread has queried the datasource yet
+        bool queued_;
+        // a worker is querying the datasource
+        bool pending_;
+        // the following layer on the same datasource
+        layer_rendering_material * next_;
+        fetch_queue * queue_;
+        boost::mutex mutex_;
+        boost::condition cond_;
+#endif
+    };
+    
+    typedef boost::shared_ptr<layer_rendering_material> material_ptr;
+
+#ifdef MAPNIK_THREADSAFE
+    /** Work queue of layers to prefetch. Of the layers sharing a
+      * datasource only the first is ready to be fetched, the next one
+      * becomes ready when the rendering thread finished the previous
+      * one. A datasource thus never runs a query while features of
+      * another are still read from it, datasources are not required to
+      * handle concurrent queries. Workers only wait for ready layers
+      * and the rendering thread queries layers no worker has started
+      * itself, so neither ever waits for the other to make progress.
+      */
+    class fetch_queue : private boost::noncopyable
+    {
+    public:
+        explicit fetch_queue(unsigned page_size)
+            : page_size_(page_size),
+              chains_(0),
+              closed_(false) {}
+
+        void push(layer_rendering_material & mat)
+        {
+            mat.queued_ = true;
+            mat.queue_ = this;
+            datasource const* ds = mat.ds_.get();
+            typename std::map<datasource const*,layer_rendering_material*>::iterator itr = last_.find(ds);
+            if (itr == last_.end())
+            {
+                last_.insert(std::make_pair(ds,&mat));
+                ready_.push_back(&mat);
+                ++chains_;
+            }
+            else
+            {
+                itr->second->next_ = &mat;
+                itr->second = &mat;
+            }
+        }
+
+        /** Number of datasources, at most as many layers are fetched at once. */
+        unsigned size() const
+        {
+            return chains_;
+        }
+
+        void ready(layer_rendering_material & mat)
+        {
+            boost::mutex::scoped_lock lock(mutex_);
+            if (closed_) return;
+            ready_.push_back(&mat);
+            cond_.notify_one();
+        }
+
+        /** Lets the workers return once the queue is empty. */
+        void close()
+        {
+            boost::mutex::scoped_lock lock(mutex_);
+            closed_ = true;
+            ready_.clear();
+            cond_.notify_all();
+        }
+
+        void run()
+        {
+            layer_rendering_material * mat;
+            while ((mat = pop()))
+            {
+                mat->fetch(page_size_);
+            }
+        }
+
+    private:
+        layer_rendering_material * pop()
+        {
+            boost::mutex::scoped_lock lock(mutex_);
+            while (ready_.empty() && !closed_) cond_.wait(lock);
+            if (ready_.empty()) return 0;
+            layer_rendering_material * mat = ready_.front();
+            ready_.pop_front();
+            return mat;
+        }
+
+        unsigned page_size_;
+        unsigned chains_;
+        bool closed_;
+        std::map<datasource const*,layer_rendering_material*> last_;
+        std::deque<layer_rendering_material*> ready_;
+        boost::mutex mutex_;
+        boost::condition cond_;
+    };
+
+    struct worker_group : public boost::thread_group
+    {
+        ~worker_group()
+        {
+            join_all();
+        }
+    };
+#endif
+
 public:
     explicit feature_style_processor(Map const& m, double scale_factor = 1.0)
         : m_(m),
-          scale_factor_(scale_factor) {}
+          scale_factor_(scale_factor),
+          prefetch_threads_(0),
+          prefetch_page_size_(1024),
+          arena_allocation_(false) {}
+
+    /** Issue the datasource queries of all visible vector layers
+      * concurrently on up to `threads` worker threads. Symbolization
+      * still happens in layer order, so the output is unchanged.
+      * Only effective when built with MAPNIK_THREADSAFE.
+      * \param threads  Number of worker threads, 0 or 1 disables prefetching
+      */
+    void set_prefetch_threads(unsigned threads)
+    {
+        prefetch_threads_ = threads;
+    }
+
+    unsigned prefetch_threads() const
+    {
+        return prefetch_threads_;
+    }
+
+    /** Number of features read ahead per layer by the prefetch workers.
+      */
+    void set_prefetch_page_size(unsigned page_size)
+    {
+        prefetch_page_size_ = page_size;
+    }
+
+    unsigned prefetch_page_size() const
+    {
+        return prefetch_page_size_;
+    }
+
+    /** Allocate the features, geometries and attributes of each layer
+      * from an arena released in one go once the layer is rendered,
+      * instead of freeing them one by one. Renderers and datasources
+      * must not keep features beyond the layer they were read for.
+      */
+    void set_arena_allocation(bool enabled)
+    {
+        arena_allocation_ = enabled;
+    }
+
+    bool arena_allocation() const
+    {
+        return arena_allocation_;
+    }
     
     void apply()
     {
@@ -107,11 +392,66 @@ public:
 #ifdef MAPNIK_DEBUG
             std::clog << "scale denominator = " << scale_denom << "\n";
 #endif
-            BOOST_FOREACH ( layer const& lyr, m_.layers() )
+#ifdef MAPNIK_THREADSAFE
+            if (prefetch_threads_ > 1)
             {
-                if (lyr.isVisible(scale_denom))
+                std::vector<material_ptr> materials;
+                fetch_queue queue(prefetch_page_size_);
+                BOOST_FOREACH ( layer const& lyr, m_.layers() )
+                {
+                    if (lyr.isVisible(scale_denom))
+                    {
+                        material_ptr mat(new layer_rendering_material(lyr));
+                        prepare_layer(*mat, proj, scale_denom);
+                        // layers without active styles are never queried
+                        if (mat->q_ && mat->ds_->type() == datasource::Vector &&
+                            !mat->active_styles_.empty())
+                        {
+                            queue.push(*mat);
+                        }
+                        materials.push_back(mat);
+                    }
+                }
+
+                worker_group workers;
+                unsigned num_workers = std::min(prefetch_threads_, queue.size());
+                for (unsigned i = 0; i < num_workers; ++i)
                 {
-                    apply_to_layer(lyr, p, proj, scale_denom);
+                    workers.create_thread(boost::bind(&fetch_queue::run, &queue));
+                }
+
+                try
+                {
+                    BOOST_FOREACH ( material_ptr const& mat, materials )
+                    {
+                        render_material(*mat, p, proj);
+                        mat->finish();
+                        if (mat->arena_) mat->arena_->release();
+                    }
+                    queue.close();
+                }
+                catch (...)
+                {
+                    // no further fetches, waits for those still running
+                    queue.close();
+                    BOOST_FOREACH ( material_ptr const& mat, materials )
+                    {
+                        mat->finish();
+                    }
+                    throw;
+                }
+            }
+            else
+#endif
+            {
+                BOOST_FOREACH ( layer const& lyr, m_.layers() )
+                {
+                    if (lyr.isVisible(scale_denom))
+                    {
+                        layer_rendering_material mat(lyr);
+                        prepare_layer(mat, proj, scale_denom);
+                        render_material(mat, p, proj);
+                    }
                 }
             }
 
@@ -129,234 +469,337 @@ public:
         p.end_map_processing(m_);
     }   
 private:
-    void apply_to_layer(layer const& lay, Processor & p, 
-                        projection const& proj0, double scale_denom)
+    /** Collects the active styles of a layer and builds its query.
+      * The query is left unset if the layer is outside of the map extent.
+      */
+    void prepare_layer(layer_rendering_material & mat,
+                       projection const& proj0, double scale_denom)
     {
-#ifdef MAPNIK_DEBUG
-        //wall_clock_progress_timer timer(clog, "end layer rendering: ");
-#endif
-        boost::shared_ptr<datasource> ds = lay.datasource();
-        if (!ds) {
+        layer const& lay = mat.lay_;
+        if (arena_allocation_) mat.arena_.reset(new arena);
+        mat.ds_ = lay.datasource();
+        if (!mat.ds_) {
             std::clog << "WARNING: No datasource for layer '" << lay.name() << "'\n";
             return;
         }
-        p.start_layer_processing(lay);
-        if (ds)
-        {
-            box2d<double> ext = m_.get_buffered_extent();
-            projection proj1(lay.srs());
-            proj_transform prj_trans(proj0,proj1);
+        
+        boost::shared_ptr<datasource> const& ds = mat.ds_;
+        box2d<double> ext = m_.get_buffered_extent();
+        mat.proj1_.reset(new projection(lay.srs()));
+        proj_transform prj_trans(proj0,*mat.proj1_);
 
-            box2d<double> layer_ext = lay.envelope();
+        box2d<double> layer_ext = lay.envelope();
                
-            double lx0 = layer_ext.minx();
-            double ly0 = layer_ext.miny();
-            double lz0 = 0.0;
-            double lx1 = layer_ext.maxx();
-            double ly1 = layer_ext.maxy();
-            double lz1 = 0.0;
-            // back project layers extent into main map projection
-            prj_trans.backward(lx0,ly0,lz0);
-            prj_trans.backward(lx1,ly1,lz1);
+        double lx0 = layer_ext.minx();
+        double ly0 = layer_ext.miny();
+        double lz0 = 0.0;
+        double lx1 = layer_ext.maxx();
+        double ly1 = layer_ext.maxy();
+        double lz1 = 0.0;
+        // back project layers extent into main map projection
+        prj_trans.backward(lx0,ly0,lz0);
+        prj_trans.backward(lx1,ly1,lz1);
                
-            // if no intersection then nothing to do for layer
-            if ( lx0 > ext.maxx() || lx1 < ext.minx() || ly0 > ext.maxy() || ly1 < ext.miny() )
-            {
-                return;
-            }
+        // if no intersection then nothing to do for layer
+        if ( lx0 > ext.maxx() || lx1 < ext.minx() || ly0 > ext.maxy() || ly1 < ext.miny() )
+        {
+            return;
+        }
       
-            // clip query bbox
-            lx0 = std::max(ext.minx(),lx0);
-            ly0 = std::max(ext.miny(),ly0);
-            lx1 = std::min(ext.maxx(),lx1);
-            ly1 = std::min(ext.maxy(),ly1);
+        // clip query bbox
+        lx0 = std::max(ext.minx(),lx0);
+        ly0 = std::max(ext.miny(),ly0);
+        lx1 = std::min(ext.maxx(),lx1);
+        ly1 = std::min(ext.maxy(),ly1);
+        box2d<double> map_bbox(lx0,ly0,lx1,ly1);
             
-            prj_trans.forward(lx0,ly0,lz0);
-            prj_trans.forward(lx1,ly1,lz1);
-            box2d<double> bbox(lx0,ly0,lx1,ly1);
+        prj_trans.forward(lx0,ly0,lz0);
+        prj_trans.forward(lx1,ly1,lz1);
+        box2d<double> bbox(lx0,ly0,lx1,ly1);
             
-            query::resolution_type res(m_.width()/m_.get_current_extent().width(),m_.height()/m_.get_current_extent().height());
-            query q(bbox,res,scale_denom); //BBOX query
+        // datasources get the resolution in pixels per layer unit: the
+        // pixels covered by the query box over its size in the layer srs
+        double res_x = m_.width()/m_.get_current_extent().width();
+        double res_y = m_.height()/m_.get_current_extent().height();
+        if (bbox.width() > 0.0 && bbox.height() > 0.0)
+        {
+            res_x *= map_bbox.width() / bbox.width();
+            res_y *= map_bbox.height() / bbox.height();
+        }
+        query::resolution_type res(res_x,res_y);
+        query q(bbox,res,scale_denom); //BBOX query
                            
-            std::vector<feature_type_style*> active_styles;
-            std::set<std::string> names;
-            attribute_collector collector(names);
+        std::set<std::string> names;
+        attribute_collector collector(names);
             
-            std::vector<std::string> const& style_names = lay.styles();
-            // iterate through all named styles collecting active styles and attribute names
-            BOOST_FOREACH(std::string const& style_name, style_names)
+        std::vector<std::string> const& style_names = lay.styles();
+        // iterate through all named styles collecting active styles and attribute names
+        BOOST_FOREACH(std::string const& style_name, style_names)
+        {
+            boost::optional<feature_type_style const&> style=m_.find_style(style_name);
+            if (!style) 
             {
-                boost::optional<feature_type_style const&> style=m_.find_style(style_name);
-                if (!style) 
-                {
-                    std::clog << "WARNING: style '" << style_name << "' required for layer '" << lay.name() << "' does not exist.\n";
-                    continue;
-                }
+                std::clog << "WARNING: style '" << style_name << "' required for layer '" << lay.name() << "' does not exist.\n";
+                continue;
+            }
                 
-                const std::vector<rule_type>& rules=(*style).get_rules();
-                bool active_rules=false;
+            const std::vector<rule_type>& rules=(*style).get_rules();
+            bool active_rules=false;
                 
-                BOOST_FOREACH(rule_type const& rule, rules)
+            BOOST_FOREACH(rule_type const& rule, rules)
+            {
+                if (rule.active(scale_denom))
                 {
-                    if (rule.active(scale_denom))
+                    active_rules = true;
+                    if (ds->type() == datasource::Vector)
                     {
-                        active_rules = true;
-                        if (ds->type() == datasource::Vector)
-                        {
-                            collector(rule);
-                        }
-                        // TODO - in the future rasters should be able to be filtered.
+                        collector(rule);
                     }
-                }
-                if (active_rules)
-                {
-                    active_styles.push_back(const_cast<feature_type_style*>(&(*style)));
+                    // TODO - in the future rasters should be able to be filtered.
                 }
             }
-            
-            // push all property names
-            BOOST_FOREACH(std::string const& name, names)
+            if (active_rules)
             {
-                q.add_property_name(name);
+                mat.active_styles_.push_back(const_cast<feature_type_style*>(&(*style)));
             }
+        }
             
-            memory_datasource cache;
-            bool cache_features = style_names.size()>1?true:false;
-            bool first = true;
+        // push all property names
+        BOOST_FOREACH(std::string const& name, names)
+        {
+            q.add_property_name(name);
+        }
+        mat.q_ = q;
+    }
+
+    void render_material(layer_rendering_material & mat, Processor & p, 
+                         projection const& proj0)
+    {
+#ifdef MAPNIK_DEBUG
+        //wall_clock_progress_timer timer(clog, "end layer rendering: ");
+#endif
+        layer const& lay = mat.lay_;
+        boost::shared_ptr<datasource> const& ds = mat.ds_;
+        if (!ds) return;
+        
+        p.start_layer_processing(lay);
+        if (!mat.q_) return;
+        
+        proj_transform layer_trans(proj0,*mat.proj1_);
+        query & q = *mat.q_;
+        double scale_denom = q.scale_denominator();
+
+        // vector features are reprojected once when they are read, so
+        // the symbolizers of all styles see map coordinates
+        bool reproject = ds->type() == datasource::Vector && !layer_trans.equal();
+        proj_transform identity(proj0,proj0);
+        proj_transform const& prj_trans = reproject ? identity : layer_trans;
+        projection_buffers buffers;
+
+        // the arena is released by the caller, after the cache is gone
+        arena_scope scope(mat.arena_.get());
+        memory_datasource cache;
+        bool cache_features = lay.styles().size()>1?true:false;
+        bool first = true;
             
-            BOOST_FOREACH (feature_type_style * style, active_styles)
-            {
-                std::vector<rule_type*> if_rules;
-                std::vector<rule_type*> else_rules;
+        BOOST_FOREACH (feature_type_style * style, mat.active_styles_)
+        {
+            std::vector<rule_type*> if_rules;
+            std::vector<rule_type*> else_rules;
+            // filters resolved against the attribute layout of the
+            // features, compiled once per style instead of walking the
+            // expression tree with string lookups for every feature
+            std::vector<compiled_expression> if_filters;
+            std::vector<expression_ptr> if_exprs;
 
-                std::vector<rule_type> const& rules=style->get_rules();
+            std::vector<rule_type> const& rules=style->get_rules();
                 
-                BOOST_FOREACH(rule_type const& rule, rules)
+            BOOST_FOREACH(rule_type const& rule, rules)
+            {
+                if (rule.active(scale_denom))
                 {
-                    if (rule.active(scale_denom))
+                    if (rule.has_else_filter())
                     {
-                        if (rule.has_else_filter())
-                        {
-                            else_rules.push_back(const_cast<rule_type*>(&rule));
-                        }
-                        else
-                        {
-                            if_rules.push_back(const_cast<rule_type*>(&rule));
-                        }
+                        else_rules.push_back(const_cast<rule_type*>(&rule));
+                    }
+                    else
+                    {
+                        if_rules.push_back(const_cast<rule_type*>(&rule));
+                        if_filters.push_back(compiled_expression(rule.get_filter()));
+                        if_exprs.push_back(rule.get_filter());
+                    }
                         
-                        if (ds->type() == datasource::Raster)
+                    if (ds->type() == datasource::Raster)
+                    {
+                        if (ds->params().get<double>("filter_factor",0.0) == 0.0)
                         {
-                            if (ds->params().get<double>("filter_factor",0.0) == 0.0)
-                            {
-                                rule_type::symbolizers const& symbols = rule.get_symbolizers();
-                                rule_type::symbolizers::const_iterator symIter = symbols.begin();
-                                rule_type::symbolizers::const_iterator symEnd = symbols.end();
-                                for (;symIter != symEnd;++symIter)
-                                {   
-                                    try
-                                    {
-                                        raster_symbolizer const& sym = boost::get<raster_symbolizer>(*symIter);
-                                        std::string const& scaling = sym.get_scaling();
-                                        if (scaling == "bilinear" || scaling == "bilinear8" )
-                                        {
-                                            // todo - allow setting custom value in symbolizer property?
-                                            q.filter_factor(2.0);
-                                        }
-                                    }
-                                    catch (const boost::bad_get &v)
+                            rule_type::symbolizers const& symbols = rule.get_symbolizers();
+                            rule_type::symbolizers::const_iterator symIter = symbols.begin();
+                            rule_type::symbolizers::const_iterator symEnd = symbols.end();
+                            for (;symIter != symEnd;++symIter)
+                            {   
+                                try
+                                {
+                                    raster_symbolizer const& sym = boost::get<raster_symbolizer>(*symIter);
+                                    std::string const& scaling = sym.get_scaling();
+                                    if (scaling == "bilinear" || scaling == "bilinear8" )
                                     {
-                                        // case where useless symbolizer is attached to raster layer
-                                        //throw config_error("Invalid Symbolizer type supplied, only RasterSymbolizer is supported");
+                                        // todo - allow setting custom value in symbolizer property?
+                                        q.filter_factor(2.0);
                                     }
                                 }
+                                catch (const boost::bad_get &v)
+                                {
+                                    // case where useless symbolizer is attached to raster layer
+                                    //throw config_error("Invalid Symbolizer type supplied, only RasterSymbolizer is supported");
+                                }
                             }
                         }
                     }
                 }
+            }
                 
-                // process features
-                featureset_ptr fs;
-                if (cache_features)
-                {
-                    if (first)
-                    {
-                        first = false;
-                        fs = ds->features(q);
-                    }
-                    else
-                    {
-                        fs = cache.features(q);
-                    }
-                }
-                else
-                {
-                    fs = ds->features(q);
-                }
+            // rules comparing the same attribute with constants are
+            // looked up by the attribute value instead of tested one by one
+            filter_dispatch dispatch(if_exprs);
+
+            // process features
+            // the first style reads the datasource and fills the cache,
+            // later styles read the cached, already projected, features
+            featureset_ptr fs;
+            bool from_cache = cache_features && !first;
+            first = false;
+            if (from_cache)
+            {
+                fs = cache.features(query(cache.envelope(),q.resolution(),scale_denom));
+            }
+            else
+            {
+                fs = mat.features(q);
+            }
                 
-                if (fs)
-                {               
-                    feature_ptr feature;
-                    while ((feature = fs->next()))
-                    {                  
-                        bool do_else=true;
-                        
+            if (fs)
+            {               
+                feature_ptr feature;
+                while ((feature = fs->next()))
+                {                  
+                    bool do_else=true;
+
+                    if (!from_cache)
+                    {
+                        if (reproject)
+                        {
+                            feature = project_feature(*feature, layer_trans, buffers);
+                        }
                         if (cache_features)
                         {
                             cache.push(feature);
                         }
+                    }
                         
-                        BOOST_FOREACH(rule_type * rule, if_rules )
-                        {
-                            expression_ptr const& expr=rule->get_filter();    
-                            value_type result = boost::apply_visitor(evaluate<Feature,value_type>(*feature),*expr);
-                            if (result.to_bool())
-                            {   
-                                do_else=false;
-                                rule_type::symbolizers const& symbols = rule->get_symbolizers();
+                    BOOST_FOREACH(filter_dispatch::candidate const& c, dispatch.lookup(*feature))
+                    {
+                        rule_type * rule = if_rules[c.rule];
+                        if (c.matched || if_filters[c.rule].evaluate(*feature).to_bool())
+                        {   
+                            do_else=false;
+                            rule_type::symbolizers const& symbols = rule->get_symbolizers();
 
-                                // if the underlying renderer is not able to process the complete set of symbolizers,
-                                // process one by one.
+                            // if the underlying renderer is not able to process the complete set of symbolizers,
+                            // process one by one.
 #ifdef SVG_RENDERER
-                                if(!p.process(symbols,*feature,prj_trans))
+                            if(!p.process(symbols,*feature,prj_trans))
 #endif
-                                {
+                            {
 
-                                    BOOST_FOREACH (symbolizer const& sym, symbols)
-                                    {   
-                                        boost::apply_visitor(symbol_dispatch(p,*feature,prj_trans),sym);
-                                    }
+                                BOOST_FOREACH (symbolizer const& sym, symbols)
+                                {   
+                                    boost::apply_visitor(symbol_dispatch(p,*feature,prj_trans),sym);
                                 }
                             }
                         }
-                        if (do_else)
+                    }
+                    if (do_else)
+                    {
+                        BOOST_FOREACH( rule_type * rule, else_rules )
                         {
-                            BOOST_FOREACH( rule_type * rule, else_rules )
-                            {
-                                rule_type::symbolizers const& symbols = rule->get_symbolizers();
-                                // if the underlying renderer is not able to process the complete set of symbolizers,
-                                // process one by one.
+                            rule_type::symbolizers const& symbols = rule->get_symbolizers();
+                            // if the underlying renderer is not able to process the complete set of symbolizers,
+                            // process one by one.
 #ifdef SVG_RENDERER
-                                if(!p.process(symbols,*feature,prj_trans))
+                            if(!p.process(symbols,*feature,prj_trans))
 #endif
+                            {
+                                BOOST_FOREACH (symbolizer const& sym, symbols)
                                 {
-                                    BOOST_FOREACH (symbolizer const& sym, symbols)
-                                    {
-                                        boost::apply_visitor(symbol_dispatch(p,*feature,prj_trans),sym);
-                                    }
+                                    boost::apply_visitor(symbol_dispatch(p,*feature,prj_trans),sym);
                                 }
                             }
                         }
                     }
-                    cache_features = false;
                 }
             }
         }
         
         p.end_layer_processing(lay);
     } 
+
+    /** Scratch space reused while projecting the features of a layer. */
+    struct projection_buffers
+    {
+        std::vector<double> xs;
+        std::vector<double> ys;
+        std::vector<unsigned> cmds;
+    };
+
+    /** Returns a copy of feature with its geometries back projected
+      * into the map projection in one batch per geometry. The feature
+      * itself is left alone, datasources may hand it out again.
+      */
+    static feature_ptr project_feature(Feature const& feature,
+                                       proj_transform const& prj_trans,
+                                       projection_buffers & buffers)
+    {
+        feature_ptr projected(feature_factory::create(feature.get_context(), feature.id()));
+        projected->copy_attributes(feature);
+        for (unsigned i = 0; i < feature.num_geometries(); ++i)
+        {
+            geometry2d const& geom = feature.get_geometry(i);
+            unsigned size = geom.num_points();
+            buffers.xs.resize(size);
+            buffers.ys.resize(size);
+            buffers.cmds.resize(size);
+            for (unsigned j = 0; j < size; ++j)
+            {
+                buffers.cmds[j] = geom.get_vertex(j, &buffers.xs[j], &buffers.ys[j]);
+            }
+            if (size > 0)
+            {
+                prj_trans.backward(&buffers.xs[0], &buffers.ys[0], 0, size);
+            }
+            geometry2d * copy = new geometry2d;
+            copy->set_capacity(size);
+            for (unsigned j = 0; j < size; ++j)
+            {
+                if (buffers.cmds[j] == SEG_MOVETO)
+                {
+                    copy->move_to(buffers.xs[j], buffers.ys[j]);
+                }
+                else
+                {
+                    copy->line_to(buffers.xs[j], buffers.ys[j]);
+                }
+            }
+            projected->add_geometry(copy);
+        }
+        return projected;
+    }
     
     Map const& m_;
     double scale_factor_;
+    unsigned prefetch_threads_;
+    unsigned prefetch_page_size_;
+    bool arena_allocation_;
 };
 }
 
@@ -0,0 +1,126 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_FILTER_DISPATCH_HPP
+#define MAPNIK_FILTER_DISPATCH_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/filter_factory.hpp>
+#include <mapnik/compiled_expression.hpp>
+// boost
+#include <boost/unordered_map.hpp>
+#include <boost/optional.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/utility.hpp>
+// stl
+#include <vector>
+#include <string>
+
+namespace mapnik
+{
+
+/** Hashable form of a value, built so that two keys are equal exactly
+  * when value::operator== holds for the values: ints and doubles are
+  * compared as doubles, bools and strings only with their own type.
+  */
+struct dispatch_key
+{
+    enum key_type { numeric, boolean, string };
+
+    key_type type;
+    double number;
+    UnicodeString str;
+
+    bool operator==(dispatch_key const& other) const
+    {
+        if (type != other.type) return false;
+        if (type == string) return str == other.str;
+        return number == other.number;
+    }
+};
+
+MAPNIK_DECL std::size_t hash_value(dispatch_key const& key);
+
+/** Returns the key of v, none for values that equal nothing (null). */
+MAPNIK_DECL boost::optional<dispatch_key> make_dispatch_key(value_type const& v);
+
+/** Selects the rules that can match a feature without testing all of them.
+  *
+  * Stylesheets often consist of long lists of rules like
+  * [highway] = 'primary', [highway] = 'secondary', ... . The rules that
+  * compare the same attribute with a constant are put into a hash table
+  * keyed by the constant. For a feature, the table lookup of the attribute
+  * value yields the rules whose filter is known to be true plus all rules
+  * that were not dispatched, in the original rule order.
+  */
+class MAPNIK_DECL filter_dispatch : private boost::noncopyable
+{
+public:
+    struct candidate
+    {
+        candidate(std::size_t r, bool m)
+            : rule(r), matched(m) {}
+        std::size_t rule;  // index into the filters passed to the constructor
+        bool matched;      // filter known to be true, no need to evaluate it
+    };
+    typedef std::vector<candidate> candidates;
+
+    /** Dispatches on an attribute once that many rules compare it to a constant. */
+    static const std::size_t min_dispatch_rules = 3;
+
+    explicit filter_dispatch(std::vector<expression_ptr> const& filters);
+
+    bool enabled() const
+    {
+        return attribute_ ? true : false;
+    }
+
+    std::string const& attribute_name() const
+    {
+        return attribute_name_;
+    }
+
+    candidates const& lookup(Feature const& f) const
+    {
+        if (!attribute_) return others_;
+        boost::optional<dispatch_key> key = make_dispatch_key(attribute_->evaluate(f));
+        if (!key) return others_;
+        table_type::const_iterator itr = table_.find(*key);
+        return itr != table_.end() ? itr->second : others_;
+    }
+
+private:
+    typedef boost::unordered_map<dispatch_key,candidates> table_type;
+
+    std::string attribute_name_;
+    boost::scoped_ptr<compiled_expression> attribute_;
+    table_type table_;
+    candidates others_;
+};
+
+}
+
+#endif // MAPNIK_FILTER_DISPATCH_HPP
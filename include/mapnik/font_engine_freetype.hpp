@@ -45,6 +45,7 @@ extern "C"
 #include <boost/shared_ptr.hpp>
 #include <boost/utility.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/unordered_map.hpp>
 #ifdef MAPNIK_THREADSAFE
 #include <boost/thread/mutex.hpp>
 #endif
@@ -59,10 +60,14 @@ extern "C"
 #include <unicode/ubidi.h>
 #include <unicode/ushape.h>
 
+namespace boost { namespace interprocess { class mapped_region; } }
+
 namespace mapnik
 {
 class font_face;
 
+typedef boost::shared_ptr<boost::interprocess::mapped_region> mapped_region_ptr;
+
 typedef boost::shared_ptr<font_face> face_ptr;
 
 class MAPNIK_DECL font_glyph : private boost::noncopyable
@@ -90,8 +95,12 @@ typedef boost::shared_ptr<font_glyph> glyph_ptr;
 class font_face : boost::noncopyable
 {
 public:
-    font_face(FT_Face face)
-        : face_(face) {}
+    /** \param data  Memory mapped font file the face was opened from, if
+      *               any. It is kept mapped as long as the face exists.
+      */
+    explicit font_face(FT_Face face, mapped_region_ptr const& data = mapped_region_ptr())
+        : face_(face),
+          data_(data) {}
 
     std::string  family_name() const
     {
@@ -137,6 +146,7 @@ public:
 
 private:
     FT_Face face_;
+    mapped_region_ptr data_;
 };
 
 class MAPNIK_DECL font_face_set : private boost::noncopyable
@@ -240,11 +250,113 @@ public:
     virtual ~freetype_engine();
     freetype_engine();
 private:
+    static mapped_region_ptr map_font_file(std::string const& file_name);
     FT_Library library_;
 #ifdef MAPNIK_THREADSAFE
     static boost::mutex mutex_;
 #endif
     static std::map<std::string,std::string> name2file_;
+    // font files mapped into memory once for the whole process, faces
+    // are opened from these instead of reading the files again
+    static std::map<std::string,mapped_region_ptr> file_cache_;
+};
+
+/** Coverage bitmap of a rendered glyph, positioned relative to the
+  * whole pixel the glyph origin falls into.
+  */
+struct glyph_bitmap
+{
+    int left;
+    int top;
+    unsigned width;
+    unsigned rows;
+    std::vector<unsigned char> buffer;
+};
+
+/** Rendered glyph bitmaps keyed by face, pixel size, glyph index,
+  * rotation and subpixel offset, so repeated labels and common
+  * characters are rasterized once. Rotation is quantized to whole
+  * degrees and the origin to quarter pixels. Halos are cached as
+  * separate bitmaps per halo radius. Control boxes are cached apart
+  * from the bitmaps and without the subpixel offset, so placing a
+  * label does not rasterize its glyphs.
+  *
+  * Entries refer to faces by address, the cache must not outlive the
+  * faces it was filled from. It is not synchronized.
+  */
+class MAPNIK_DECL glyph_cache : private boost::noncopyable
+{
+public:
+    enum
+    {
+        angle_steps = 360,      // rotation buckets per full turn
+        subpixel_step = 16,     // origin quantization in 26.6 units
+        max_entries = 16384     // the cache is emptied when exceeding this
+    };
+
+    glyph_cache() {}
+
+    /** Returns the bitmap of a glyph drawn with its origin at the
+      * 26.6 position pos, or 0 if FreeType fails to render it. The
+      * face must already be set to size.
+      * \param pos     In: exact origin, out: whole pixel part of the
+      *                quantized origin (in pixels)
+      * \param halo    Halo radius in 26.6 units, 0 for the glyph itself
+      */
+    glyph_bitmap const* get(FT_Face face, unsigned size, unsigned index,
+                            double angle, FT_Vector & pos,
+                            FT_Fixed halo, stroker & s);
+
+    /** Sets bbox to the control box in pixels of a glyph drawn with its
+      * origin at the 26.6 position pos, the box of the bitmap get()
+      * returns for it. False if FreeType fails to load the glyph.
+      */
+    bool get_bbox(FT_Face face, unsigned size, unsigned index,
+                  double angle, FT_Vector const& pos, FT_BBox & bbox);
+
+    void clear()
+    {
+        entries_.clear();
+        boxes_.clear();
+    }
+
+    std::size_t size() const
+    {
+        return entries_.size();
+    }
+
+private:
+    struct key
+    {
+        FT_Face face;
+        unsigned size;
+        unsigned index;
+        int angle;
+        int dx;
+        int dy;
+        FT_Fixed halo;
+
+        bool operator==(key const& other) const
+        {
+            return face == other.face && size == other.size &&
+                index == other.index && angle == other.angle &&
+                dx == other.dx && dy == other.dy && halo == other.halo;
+        }
+    };
+
+    friend std::size_t hash_value(key const& k);
+
+    // quantizes angle and pos into k, pos becomes the subpixel origin in 26.6
+    static void make_key(key & k, FT_Face face, unsigned size, unsigned index,
+                         double angle, FT_Vector & pos, FT_Fixed halo);
+    // loads the glyph of k rotated and at its subpixel offset into the face's slot
+    static bool load_glyph(key const& k);
+
+    typedef boost::unordered_map<key, boost::shared_ptr<glyph_bitmap> > entries_t;
+    // outline control boxes in 26.6 units at a zero subpixel offset
+    typedef boost::unordered_map<key, FT_BBox> boxes_t;
+    entries_t entries_;
+    boxes_t boxes_;
 };
 
 template <typename T>
@@ -306,29 +418,39 @@ public:
         return stroker_;
     }
 
+    glyph_cache & get_glyph_cache()
+    {
+        return glyph_cache_;
+    }
+
 private:
     faces faces_;
     font_engine_type & engine_;
     stroker_ptr stroker_;
+    // declared after faces_ so that it is destroyed first
+    glyph_cache glyph_cache_;
 };
 
 template <typename T>
 struct text_renderer : private boost::noncopyable
 {
-    struct glyph_t : boost::noncopyable
+    struct glyph_t
     {
-        FT_Glyph image;
-        glyph_t(FT_Glyph image_) : image(image_) {}
-        ~glyph_t () { FT_Done_Glyph(image);}
+        FT_Face face;
+        unsigned index;
+        double angle;
+        FT_Vector pen;
     };
 
-    typedef boost::ptr_vector<glyph_t> glyphs_t;
+    typedef std::vector<glyph_t> glyphs_t;
     typedef T pixmap_type;
 
-    text_renderer (pixmap_type & pixmap, face_set_ptr faces, stroker & s)
+    text_renderer (pixmap_type & pixmap, face_set_ptr faces, stroker & s, glyph_cache & cache)
         : pixmap_(pixmap),
           faces_(faces),
           stroker_(s),
+          cache_(cache),
+          size_(0),
           fill_(0,0,0),
           halo_fill_(255,255,255),
           halo_radius_(0.0),
@@ -336,6 +458,7 @@ struct text_renderer : private boost::noncopyable
 
     void set_pixel_size(unsigned size)
     {
+        size_ = size;
         faces_->set_pixel_sizes(size);
     }
 
@@ -364,10 +487,6 @@ struct text_renderer : private boost::noncopyable
         //clear glyphs
         glyphs_.clear();
 
-        FT_Matrix matrix;
-        FT_Vector pen;
-        FT_Error  error;
-
         FT_BBox bbox;
         bbox.xMin = bbox.yMin = 32000;  // Initialize these so we can tell if we
         bbox.xMax = bbox.yMax = -32000; // properly grew the bbox later
@@ -385,51 +504,41 @@ struct text_renderer : private boost::noncopyable
             //    "," << y << "," << angle << std::endl;
 #endif
 
-            FT_BBox glyph_bbox;
-            FT_Glyph image;
-
-            pen.x = int(x * 64);
-            pen.y = int(y * 64);
-
             glyph_ptr glyph = faces_->get_glyph(unsigned(c));
-            FT_Face face = glyph->get_face()->get_face();
-
-            matrix.xx = (FT_Fixed)( cos( angle ) * 0x10000L );
-            matrix.xy = (FT_Fixed)(-sin( angle ) * 0x10000L );
-            matrix.yx = (FT_Fixed)( sin( angle ) * 0x10000L );
-            matrix.yy = (FT_Fixed)( cos( angle ) * 0x10000L );
 
-            FT_Set_Transform(face, &matrix, &pen);
+            glyph_t g;
+            g.face = glyph->get_face()->get_face();
+            g.index = glyph->get_index();
+            g.angle = angle;
+            g.pen.x = int(x * 64);
+            g.pen.y = int(y * 64);
 
-            error = FT_Load_Glyph(face, glyph->get_index(), FT_LOAD_NO_HINTING);
-            if ( error )
-                continue;
-
-            error = FT_Get_Glyph(face->glyph, &image);
-            if ( error )
+            FT_BBox glyph_bbox;
+            if (!cache_.get_bbox(g.face, size_, g.index, g.angle, g.pen, glyph_bbox))
                 continue;
 
-            FT_Glyph_Get_CBox(image,ft_glyph_bbox_pixels, &glyph_bbox);
-            if (glyph_bbox.xMin < bbox.xMin)
-                bbox.xMin = glyph_bbox.xMin;
-            if (glyph_bbox.yMin < bbox.yMin)
-                bbox.yMin = glyph_bbox.yMin;
-            if (glyph_bbox.xMax > bbox.xMax)
-                bbox.xMax = glyph_bbox.xMax;
-            if (glyph_bbox.yMax > bbox.yMax)
-                bbox.yMax = glyph_bbox.yMax;
-
-            // Check if we properly grew the bbox
-            if ( bbox.xMin > bbox.xMax )
+            if (glyph_bbox.xMin < glyph_bbox.xMax || glyph_bbox.yMin < glyph_bbox.yMax)
             {
-                bbox.xMin = 0;
-                bbox.yMin = 0;
-                bbox.xMax = 0;
-                bbox.yMax = 0;
+                if (glyph_bbox.xMin < bbox.xMin)
+                    bbox.xMin = glyph_bbox.xMin;
+                if (glyph_bbox.yMin < bbox.yMin)
+                    bbox.yMin = glyph_bbox.yMin;
+                if (glyph_bbox.xMax > bbox.xMax)
+                    bbox.xMax = glyph_bbox.xMax;
+                if (glyph_bbox.yMax > bbox.yMax)
+                    bbox.yMax = glyph_bbox.yMax;
             }
 
-            // take ownership of the glyph
-            glyphs_.push_back(new glyph_t(image));
+            glyphs_.push_back(g);
+        }
+
+        // Check if we properly grew the bbox
+        if ( bbox.xMin > bbox.xMax )
+        {
+            bbox.xMin = 0;
+            bbox.yMin = 0;
+            bbox.xMax = 0;
+            bbox.yMax = 0;
         }
 
         return box2d<double>(bbox.xMin, bbox.yMin, bbox.xMax, bbox.yMax);
@@ -437,7 +546,6 @@ struct text_renderer : private boost::noncopyable
 
     void render(double x0, double y0)
     {
-        FT_Error  error;
         FT_Vector start;
         unsigned height = pixmap_.height();
 
@@ -445,48 +553,21 @@ struct text_renderer : private boost::noncopyable
         start.y =  static_cast<FT_Pos>((height - y0) * (1 << 6));
 
         // now render transformed glyphs
-        typename glyphs_t::iterator pos;
+        typename glyphs_t::const_iterator pos;
 
         //make sure we've got reasonable values.
         if (halo_radius_ > 0.0 && halo_radius_ < 1024.0)
         {
-            stroker_.init(halo_radius_);   
+            FT_Fixed halo = static_cast<FT_Fixed>(halo_radius_ * (1 << 6));
             for ( pos = glyphs_.begin(); pos != glyphs_.end();++pos)
             {
-                FT_Glyph g;
-                error = FT_Glyph_Copy(pos->image, &g);
-                if (!error)
-                {
-                    FT_Glyph_Transform(g,0,&start);
-                    FT_Glyph_Stroke(&g,stroker_.get(),1);
-                    error = FT_Glyph_To_Bitmap( &g,FT_RENDER_MODE_NORMAL,0,1);
-                    if ( ! error )
-                    {
-                        
-                        FT_BitmapGlyph bit = (FT_BitmapGlyph)g;
-                        render_bitmap(&bit->bitmap, halo_fill_.rgba(),
-                                      bit->left,
-                                      height - bit->top);
-                    }
-                }
-                FT_Done_Glyph(g);
-            }    
+                render_glyph(*pos, start, halo, halo_fill_.rgba());
+            }
         }
         //render actual text
         for ( pos = glyphs_.begin(); pos != glyphs_.end();++pos)
         {
-
-            FT_Glyph_Transform(pos->image,0,&start);
-
-            error = FT_Glyph_To_Bitmap( &(pos->image),FT_RENDER_MODE_NORMAL,0,1);
-            if ( ! error )
-            {
-
-                FT_BitmapGlyph bit = (FT_BitmapGlyph)pos->image;
-                render_bitmap(&bit->bitmap, fill_.rgba(),
-                              bit->left,
-                              height - bit->top);
-            }
+            render_glyph(*pos, start, 0, fill_.rgba());
         }
     }
 
@@ -513,17 +594,30 @@ private:
         }
     }
 
-    void render_bitmap(FT_Bitmap *bitmap,unsigned rgba,int x,int y)
+    void render_glyph(glyph_t const& g, FT_Vector const& start, FT_Fixed halo, unsigned rgba)
     {
-        int x_max=x+bitmap->width;
-        int y_max=y+bitmap->rows;
+        FT_Vector pos;
+        pos.x = g.pen.x + start.x;
+        pos.y = g.pen.y + start.y;
+        glyph_bitmap const* bitmap = cache_.get(g.face, size_, g.index, g.angle, pos, halo, stroker_);
+        if (bitmap)
+        {
+            render_bitmap(*bitmap, rgba, pos.x + bitmap->left,
+                          pixmap_.height() - (pos.y + bitmap->top));
+        }
+    }
+
+    void render_bitmap(glyph_bitmap const& bitmap,unsigned rgba,int x,int y)
+    {
+        int x_max=x+bitmap.width;
+        int y_max=y+bitmap.rows;
         int i,p,j,q;
 
         for (i=x,p=0;i<x_max;++i,++p)
         {
             for (j=y,q=0;j<y_max;++j,++q)
             {
-                int gray=bitmap->buffer[q*bitmap->width+p];
+                int gray=bitmap.buffer[q*bitmap.width+p];
                 if (gray)
                 {
                     pixmap_.blendPixel2(i,j,rgba,gray,opacity_);
@@ -535,6 +629,8 @@ private:
     pixmap_type & pixmap_;
     face_set_ptr faces_;
     stroker & stroker_;
+    glyph_cache & cache_;
+    unsigned size_;
     color fill_;
     color halo_fill_;
     double halo_radius_;
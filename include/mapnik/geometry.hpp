@@ -55,10 +55,9 @@ public:
         box2d<double> result;    
         double x(0);
         double y(0);
-        rewind(0);
         for (unsigned i=0;i<num_points();++i)
         {
-            vertex(&x,&y);
+            get_vertex(i,&x,&y);
             if (i==0)
             {
                 result.init(x,y,x,y);
@@ -78,8 +77,7 @@ public:
     virtual void move_to(value_type x,value_type y)=0;
     virtual void line_to(value_type x,value_type y)=0;
     virtual unsigned num_points() const = 0;
-    virtual unsigned vertex(double* x, double* y) const=0;
-    virtual void rewind(unsigned) const=0;
+    virtual unsigned get_vertex(unsigned pos, double* x, double* y) const=0;
     virtual void set_capacity(size_t size)=0;
     virtual ~geometry() {}
 };
@@ -124,15 +122,14 @@ public:
         return 1;
     }
          
-    unsigned vertex(double* x, double* y) const
+    unsigned get_vertex(unsigned pos, double* x, double* y) const
     {
+        if (pos > 0) return SEG_END;
         *x = pt_.x;
         *y = pt_.y;
         return SEG_LINETO;
     }
          
-    void rewind(unsigned ) const {}
-         
     bool hit_test(value_type x,value_type y, double tol) const
     {
         return point_in_circle(pt_.x,pt_.y, x,y,tol);
@@ -151,7 +148,6 @@ public:
     typedef Container<vertex_type> container_type;   
 private:
     container_type cont_;
-    mutable unsigned itr_;
 public:
 
     typedef typename container_type::const_iterator iterator;
@@ -166,9 +162,10 @@ public:
 	return cont_.end();
     }
 
+    MAPNIK_ARENA_ALLOCATED
+
     polygon()
-        : //geometry_base(),
-        itr_(0)
+        //: geometry_base()
     {}
          
     int type() const 
@@ -181,13 +178,12 @@ public:
         double sum = 0.0;
         double x(0);
         double y(0);
-        rewind(0);
         double xs = x;
         double ys = y;
         for (unsigned i=0;i<num_points();++i)
         {
             double x0,y0;
-            vertex(&x0,&y0);
+            get_vertex(i,&x0,&y0);
             sum += x * y0 - y * x0;
             x = x0;
             y = y0;
@@ -200,10 +196,9 @@ public:
         box2d<double> result;
         double x(0);
         double y(0);
-        rewind(0);
         for (unsigned i=0;i<num_points();++i)
         {
-            vertex(&x,&y);
+            get_vertex(i,&x,&y);
             if (i==0)
             {
                 result.init(x,y,x,y);
@@ -330,14 +325,10 @@ public:
         return cont_.size();
     }
          
-    unsigned vertex(double* x, double* y) const
-    {
-        return cont_.get_vertex(itr_++,x,y);
-    }         
-
-    void rewind(unsigned ) const
+    /** Reads vertex pos without touching any state. */
+    unsigned get_vertex(unsigned pos, double* x, double* y) const
     {
-        itr_=0;
+        return cont_.get_vertex(pos,x,y);
     }
          
     bool hit_test(value_type x,value_type y, double) const
@@ -361,11 +352,11 @@ class line_string : public geometry<T>
     typedef Container<vertex_type> container_type;
 private:
     container_type cont_;
-    mutable unsigned itr_;
 public:
+    MAPNIK_ARENA_ALLOCATED
+
     line_string()
-        : geometry_base(),
-          itr_(0)
+        : geometry_base()
     {}
          
     int type() const 
@@ -444,14 +435,9 @@ public:
         return cont_.size();
     }
          
-    unsigned vertex(double* x, double* y) const
-    {
-        return cont_.get_vertex(itr_++,x,y);
-    }
-         
-    void rewind(unsigned ) const
+    unsigned get_vertex(unsigned pos, double* x, double* y) const
     {
-        itr_=0;
+        return cont_.get_vertex(pos,x,y);
     }
          
     bool hit_test(value_type x,value_type y, double tol) const
@@ -27,12 +27,23 @@
 
 // mapnik
 #include <mapnik/quad_tree.hpp>
+// boost
+#include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
 // stl
 #include <vector>
+#include <algorithm>
+#include <cmath>
 #include <unicode/unistr.h>
 
 namespace mapnik
 {
+enum label_detector_enum {
+    QUAD_TREE_DETECTOR,
+    GRID_DETECTOR,
+    label_detector_enum_MAX
+};
+
 //this needs to be tree structure 
 //as a proof of a concept _only_ we use sequential scan 
 
@@ -134,8 +145,179 @@ public:
     }
 };
 
+
+// uniform grid based label collision detector with the interface of
+// label_collision_detector4. Queries walk the cells covered by the box
+// without allocating and label text is interned, so the minimum
+// distance check compares integers instead of strings.
+class label_collision_grid : boost::noncopyable
+{
+    struct label
+    {
+        label(box2d<double> const& b, unsigned t) : box(b), text(t) {}
+
+        box2d<double> box;
+        unsigned text;
+    };
+
+    struct text_hash
+    {
+        std::size_t operator()(UnicodeString const& text) const
+        {
+            return text.hashCode();
+        }
+    };
+
+    typedef std::vector<unsigned> cell_t;
+    typedef boost::unordered_map<UnicodeString,unsigned,text_hash> texts_t;
+
+    box2d<double> extent_;
+    double cell_size_;
+    int cols_;
+    int rows_;
+    std::vector<label> labels_;
+    std::vector<cell_t> cells_;
+    std::vector<unsigned> used_cells_;
+    texts_t texts_;
+
+public:
+
+    explicit label_collision_grid(box2d<double> const& extent, double cell_size = 64.0)
+        : extent_(extent),
+          cell_size_(cell_size),
+          cols_(std::max(1, static_cast<int>(std::ceil(extent.width() / cell_size)))),
+          rows_(std::max(1, static_cast<int>(std::ceil(extent.height() / cell_size)))),
+          cells_(cols_ * rows_)
+    {
+        // labels without text share the empty string, as in the quad tree
+        texts_.insert(std::make_pair(UnicodeString(), 0u));
+    }
+
+    bool has_placement(box2d<double> const& box) const
+    {
+        int x0, y0, x1, y1;
+        cell_range(box, x0, y0, x1, y1);
+        for (int y = y0; y <= y1; ++y)
+        {
+            for (int x = x0; x <= x1; ++x)
+            {
+                cell_t const& cell = cells_[y * cols_ + x];
+                for (cell_t::const_iterator itr = cell.begin(); itr != cell.end(); ++itr)
+                {
+                    if (labels_[*itr].box.intersects(box))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    bool has_placement(box2d<double> const& box, UnicodeString const& text, double distance) const
+    {
+        box2d<double> bigger_box(box.minx() - distance, box.miny() - distance, box.maxx() + distance, box.maxy() + distance);
+        texts_t::const_iterator id = texts_.find(text);
+
+        int x0, y0, x1, y1;
+        cell_range(bigger_box, x0, y0, x1, y1);
+        for (int y = y0; y <= y1; ++y)
+        {
+            for (int x = x0; x <= x1; ++x)
+            {
+                cell_t const& cell = cells_[y * cols_ + x];
+                for (cell_t::const_iterator itr = cell.begin(); itr != cell.end(); ++itr)
+                {
+                    label const& lab = labels_[*itr];
+                    if (lab.box.intersects(box) ||
+                        (id != texts_.end() && id->second == lab.text && lab.box.intersects(bigger_box)))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    bool has_point_placement(box2d<double> const& box, double distance) const
+    {
+        box2d<double> bigger_box(box.minx() - distance, box.miny() - distance, box.maxx() + distance, box.maxy() + distance);
+        return has_placement(bigger_box);
+    }
+
+    void insert(box2d<double> const& box)
+    {
+        insert(box, 0);
+    }
+
+    void insert(box2d<double> const& box, UnicodeString const& text)
+    {
+        texts_t::const_iterator itr = texts_.find(text);
+        if (itr == texts_.end())
+        {
+            itr = texts_.insert(std::make_pair(text, unsigned(texts_.size()))).first;
+        }
+        insert(box, itr->second);
+    }
+
+    /** Forgets all labels but keeps the memory of the cells. Only the
+      * cells labels were inserted into are visited, so clearing a
+      * detector holding a few labels is cheap whatever its extent.
+      */
+    void clear()
+    {
+        labels_.clear();
+        for (std::vector<unsigned>::const_iterator itr = used_cells_.begin(); itr != used_cells_.end(); ++itr)
+        {
+            cells_[*itr].clear();
+        }
+        used_cells_.clear();
+    }
+
+    box2d<double> const& extent() const
+    {
+        return extent_;
+    }
+
+private:
+    void insert(box2d<double> const& box, unsigned text)
+    {
+        unsigned index = labels_.size();
+        labels_.push_back(label(box, text));
+        int x0, y0, x1, y1;
+        cell_range(box, x0, y0, x1, y1);
+        for (int y = y0; y <= y1; ++y)
+        {
+            for (int x = x0; x <= x1; ++x)
+            {
+                cell_t & cell = cells_[y * cols_ + x];
+                if (cell.empty()) used_cells_.push_back(y * cols_ + x);
+                cell.push_back(index);
+            }
+        }
+    }
+
+    // boxes beyond the extent are clamped to the border cells, which
+    // keeps intersecting boxes in common cells
+    void cell_range(box2d<double> const& box, int & x0, int & y0, int & x1, int & y1) const
+    {
+        x0 = clamp(std::floor((box.minx() - extent_.minx()) / cell_size_), cols_);
+        x1 = clamp(std::floor((box.maxx() - extent_.minx()) / cell_size_), cols_);
+        y0 = clamp(std::floor((box.miny() - extent_.miny()) / cell_size_), rows_);
+        y1 = clamp(std::floor((box.maxy() - extent_.miny()) / cell_size_), rows_);
+    }
+
+    static int clamp(double v, int size)
+    {
+        if (v < 0.0) return 0;
+        if (v >= size) return size - 1;
+        return static_cast<int>(v);
+    }
+};
     
 //quad tree based label collission detector so labels dont appear within a given distance
+//the grid above can be selected instead with GRID_DETECTOR
 class label_collision_detector4 : boost::noncopyable
 {
     struct label
@@ -149,18 +331,24 @@ class label_collision_detector4 : boost::noncopyable
          
     typedef quad_tree< label > tree_t;
     box2d<double> extent_;
-    tree_t tree_;
+    // only the selected backend is built
+    boost::scoped_ptr<tree_t> tree_;
+    boost::scoped_ptr<label_collision_grid> grid_;
          
 public:
         
-    explicit label_collision_detector4(box2d<double> const& extent)
+    explicit label_collision_detector4(box2d<double> const& extent,
+                                       label_detector_enum type = QUAD_TREE_DETECTOR)
         : extent_(extent),
-          tree_(extent) {}
+          tree_(type == GRID_DETECTOR ? 0 : new tree_t(extent)),
+          grid_(type == GRID_DETECTOR ? new label_collision_grid(extent) : 0) {}
         
     bool has_placement(box2d<double> const& box)
     {
-        tree_t::query_iterator itr = tree_.query_in_box(box);
-        tree_t::query_iterator end = tree_.query_end();
+        if (grid_) return grid_->has_placement(box);
+
+        tree_t::query_iterator itr = tree_->query_in_box(box);
+        tree_t::query_iterator end = tree_->query_end();
           
         for ( ;itr != end; ++itr)
         {
@@ -175,9 +363,10 @@ public:
 
     bool has_placement(box2d<double> const& box, UnicodeString const& text, double distance)
     {
+        if (grid_) return grid_->has_placement(box, text, distance);
         box2d<double> bigger_box(box.minx() - distance, box.miny() - distance, box.maxx() + distance, box.maxy() + distance);
-        tree_t::query_iterator itr = tree_.query_in_box(bigger_box);
-        tree_t::query_iterator end = tree_.query_end();
+        tree_t::query_iterator itr = tree_->query_in_box(bigger_box);
+        tree_t::query_iterator end = tree_->query_end();
         
         for ( ;itr != end; ++itr)
         {
@@ -192,9 +381,10 @@ public:
 
     bool has_point_placement(box2d<double> const& box, double distance)
     {
+        if (grid_) return grid_->has_point_placement(box, distance);
         box2d<double> bigger_box(box.minx() - distance, box.miny() - distance, box.maxx() + distance, box.maxy() + distance);
-        tree_t::query_iterator itr = tree_.query_in_box(bigger_box);
-        tree_t::query_iterator end = tree_.query_end();
+        tree_t::query_iterator itr = tree_->query_in_box(bigger_box);
+        tree_t::query_iterator end = tree_->query_end();
          
         for ( ;itr != end; ++itr)
         {
@@ -209,17 +399,20 @@ public:
       
     void insert(box2d<double> const& box)
     {
-        tree_.insert(label(box), box);
+        if (grid_) grid_->insert(box);
+        else tree_->insert(label(box), box);
     }
          
     void insert(box2d<double> const& box, UnicodeString const& text)
     {
-        tree_.insert(label(box, text), box);
+        if (grid_) grid_->insert(box, text);
+        else tree_->insert(label(box, text), box);
     }
          
     void clear()
     {
-        tree_.clear();
+        if (grid_) grid_->clear();
+        else tree_->clear();
     }
       
     box2d<double> const& extent() const
@@ -26,19 +26,23 @@
 
 #include <mapnik/stroke.hpp>
 #include <mapnik/symbolizer.hpp>
+#include <mapnik/vertex_filter.hpp>
 
 namespace mapnik 
 {
 struct MAPNIK_DECL line_symbolizer : public symbolizer_base
 {
     explicit line_symbolizer()
-        : symbolizer_base(), stroke_() {}
+        : symbolizer_base(), stroke_(),
+          simplify_tolerance_(0.0), simplify_algorithm_(RADIAL_DISTANCE) {}
         
     line_symbolizer(stroke const& stroke)
-        : symbolizer_base(), stroke_(stroke) {}
+        : symbolizer_base(), stroke_(stroke),
+          simplify_tolerance_(0.0), simplify_algorithm_(RADIAL_DISTANCE) {}
         
     line_symbolizer(color const& pen,float width=1.0)
-        : symbolizer_base(), stroke_(pen,width) {}
+        : symbolizer_base(), stroke_(pen,width),
+          simplify_tolerance_(0.0), simplify_algorithm_(RADIAL_DISTANCE) {}
         
     stroke const& get_stroke() const
     {
@@ -50,8 +54,28 @@ struct MAPNIK_DECL line_symbolizer : public symbolizer_base
         stroke_ = stroke;
     }
 
+    /** Vertices closer than tolerance pixels are dropped, 0 disables. */
+    void set_simplify_tolerance(double tolerance)
+    {
+        simplify_tolerance_ = tolerance;
+    }
+    double get_simplify_tolerance() const
+    {
+        return simplify_tolerance_;
+    }
+    void set_simplify_algorithm(simplify_algorithm_e algorithm)
+    {
+        simplify_algorithm_ = algorithm;
+    }
+    simplify_algorithm_e get_simplify_algorithm() const
+    {
+        return simplify_algorithm_;
+    }
+
 private:
     stroke stroke_;
+    double simplify_tolerance_;
+    simplify_algorithm_e simplify_algorithm_;
 };
 }
 
@@ -34,6 +34,7 @@
 #include <mapnik/datasource.hpp>
 #include <mapnik/layer.hpp>
 #include <mapnik/metawriter.hpp>
+#include <mapnik/label_collision_detector.hpp>
 
 // boost
 #include <boost/optional/optional.hpp>
@@ -81,6 +82,7 @@ private:
     std::vector<layer> layers_;
     aspect_fix_mode aspectFixMode_;
     box2d<double> currentExtent_;
+    label_detector_enum label_detector_;
         
 public:
 
@@ -328,6 +330,17 @@ public:
      *  @return Buffer size as int
      */
     int buffer_size() const;
+
+    /*! \brief Set the data structure labels are checked for collisions with.
+     *  @param type QUAD_TREE_DETECTOR (default) or GRID_DETECTOR, a uniform
+     *  grid that is faster for maps with many labels.
+     */
+    void set_label_detector(label_detector_enum type);
+
+    /*! \brief Get the label collision detector type
+     *  @return Detector type
+     */
+    label_detector_enum label_detector() const;
         
     /*! \brief Zoom the map at the current position.
      *  @param factor The factor how much the map is zoomed in or out.
@@ -427,6 +440,7 @@ private:
 };
    
 DEFINE_ENUM(aspect_fix_mode_e,Map::aspect_fix_mode);
+DEFINE_ENUM(label_detector_e,label_detector_enum);
 }
 
 #endif //MAP_HPP
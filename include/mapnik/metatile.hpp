@@ -0,0 +1,66 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+//$Id$
+
+#ifndef MAPNIK_METATILE_HPP
+#define MAPNIK_METATILE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/box2d.hpp>
+#include <mapnik/map.hpp>
+// stl
+#include <string>
+#include <vector>
+
+namespace mapnik
+{
+
+/** Renders a block of tiles x tiles tiles in a single pass and encodes
+  * each of them separately.
+  *
+  * Datasources are queried once for the whole block and labels are
+  * placed once, so they are consistent across inner tile edges. The
+  * block is rendered with a margin of the map's buffer_size on every
+  * side, so labels crossing the outer edges are placed as they would be
+  * for a single tile rendered with the same buffer.
+  *
+  * \param map        Styles, layers, srs and buffer size to render with,
+  *                   its size and extent are ignored
+  * \param extent     Extent of the whole block in map coordinates, has
+  *                   to be square since the tiles are; std::runtime_error
+  *                   is thrown otherwise
+  * \param tiles      Number of tiles along each side of the block
+  * \param tile_size  Width and height of a tile in pixels
+  * \param format     Image format as understood by save_to_string
+  * \return the encoded tiles row by row, top left first
+  */
+MAPNIK_DECL std::vector<std::string> render_metatile(Map const& map,
+                                                     box2d<double> const& extent,
+                                                     unsigned tiles,
+                                                     unsigned tile_size,
+                                                     std::string const& format,
+                                                     double scale_factor = 1.0);
+
+}
+
+#endif // MAPNIK_METATILE_HPP
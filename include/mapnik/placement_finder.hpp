@@ -73,6 +73,7 @@ struct placement : boost::noncopyable
     bool allow_overlap;
     std::pair<double, double> dimensions;
     int text_size;
+    bool record_envelopes; // keep the character boxes in each placement_element, for deferred labels
 };
 
 
@@ -28,6 +28,7 @@
 // mapnik
 #include <mapnik/color.hpp>
 #include <mapnik/symbolizer.hpp>
+#include <mapnik/vertex_filter.hpp>
 
 namespace mapnik 
 {
@@ -37,13 +38,17 @@ struct MAPNIK_DECL polygon_symbolizer : public symbolizer_base
         : symbolizer_base(),
         fill_(color(128,128,128)),
         opacity_(1.0),
-        gamma_(1.0) {}
+        gamma_(1.0),
+        simplify_tolerance_(0.0),
+        simplify_algorithm_(RADIAL_DISTANCE) {}
 
     polygon_symbolizer(color const& fill)
         : symbolizer_base(),
         fill_(fill),
         opacity_(1.0),
-        gamma_(1.0) {}
+        gamma_(1.0),
+        simplify_tolerance_(0.0),
+        simplify_algorithm_(RADIAL_DISTANCE) {}
         
     color const& get_fill() const
     {
@@ -69,11 +74,29 @@ struct MAPNIK_DECL polygon_symbolizer : public symbolizer_base
     {
         return gamma_;
     }
+    void set_simplify_tolerance(double tolerance)
+    {
+        simplify_tolerance_ = tolerance;
+    }
+    double get_simplify_tolerance() const
+    {
+        return simplify_tolerance_;
+    }
+    void set_simplify_algorithm(simplify_algorithm_e algorithm)
+    {
+        simplify_algorithm_ = algorithm;
+    }
+    simplify_algorithm_e get_simplify_algorithm() const
+    {
+        return simplify_algorithm_;
+    }
 
 private:
     color fill_;
     double opacity_;
     double gamma_;
+    double simplify_tolerance_;
+    simplify_algorithm_e simplify_algorithm_;
 }; 
    
 struct MAPNIK_DECL building_symbolizer : public symbolizer_base
@@ -0,0 +1,83 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef PREFETCHED_FEATURESET_HPP
+#define PREFETCHED_FEATURESET_HPP
+
+// mapnik
+#include <mapnik/datasource.hpp>
+// boost
+#include <boost/utility.hpp>
+// stl
+#include <deque>
+
+namespace mapnik {
+
+/** Featureset reading ahead the first page of another featureset.
+  *
+  * The read-ahead happens in the constructor so that it can run on a
+  * worker thread, the remaining features are pulled lazily by next().
+  */
+class prefetched_featureset : public Featureset, private boost::noncopyable
+{
+public:
+    prefetched_featureset(featureset_ptr const& fs, unsigned page_size)
+        : fs_(fs)
+    {
+        while (fs_ && page_.size() < page_size)
+        {
+            feature_ptr feature = fs_->next();
+            if (!feature)
+            {
+                fs_.reset();
+                break;
+            }
+            page_.push_back(feature);
+        }
+    }
+
+    virtual ~prefetched_featureset() {}
+
+    feature_ptr next()
+    {
+        if (!page_.empty())
+        {
+            feature_ptr feature = page_.front();
+            page_.pop_front();
+            return feature;
+        }
+        if (fs_)
+        {
+            return fs_->next();
+        }
+        return feature_ptr();
+    }
+
+private:
+    featureset_ptr fs_;
+    std::deque<feature_ptr> page_;
+};
+}
+
+#endif // PREFETCHED_FEATURESET_HPP
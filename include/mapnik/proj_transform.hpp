@@ -29,6 +29,8 @@
 #include <mapnik/projection.hpp>
 // boost
 #include <boost/utility.hpp>
+// stl
+#include <cstddef>
 
 namespace mapnik {
     
@@ -41,6 +43,11 @@ public:
     bool equal() const;
     bool forward (double& x, double& y , double& z) const;
     bool backward (double& x, double& y , double& z) const;
+    /** Transform point_count coordinates at once, the i-th point being
+      * (x[i*stride], y[i*stride], z[i*stride]). z may be null.
+      */
+    bool forward (double * x, double * y , double * z, std::size_t point_count, std::size_t stride = 1) const;
+    bool backward (double * x, double * y , double * z, std::size_t point_count, std::size_t stride = 1) const;
     mapnik::projection const& source() const;
     mapnik::projection const& dest() const;
         
@@ -50,6 +57,11 @@ private:
     bool is_source_longlat_;
     bool is_dest_longlat_;
     bool is_source_equal_dest_;
+    // set when the pair is WGS84 <-> spherical mercator, these
+    // are transformed with closed formulas instead of pj_transform
+    bool wgs84_to_merc_;
+    bool merc_to_wgs84_;
+    bool merc_wrap_;
 };
 }
 
@@ -27,6 +27,7 @@
 
 // mapnik
 #include <mapnik/box2d.hpp>
+#include <mapnik/well_known_srs.hpp>
 
 // boost
 #ifdef MAPNIK_THREADSAFE
@@ -34,6 +35,7 @@
 #endif
 
 #include <boost/utility.hpp>
+#include <boost/optional.hpp>
 // stl
 #include <string>
 #include <iostream>
@@ -48,6 +50,14 @@ public:
         : std::runtime_error("failed to initialize projection with:" + params) {}
 };
     
+/** A PROJ.4 projection.
+  *
+  * With proj >= 4.8 every projection owns its own PROJ context, so
+  * transformations do not need the global lock and render threads
+  * using their own projection objects do not contend with each other.
+  * A single projection object must not be used by several threads
+  * at the same time; copy it instead, copies are independent.
+  */
 class MAPNIK_DECL projection
 {
     friend class proj_transform;
@@ -62,6 +72,7 @@ public:
     bool is_initialized() const;
     bool is_geographic() const;
     std::string const& params() const;
+    boost::optional<well_known_srs_e> well_known() const;
       
     void forward(double & x, double &y ) const;
     void inverse(double & x,double & y) const;
@@ -73,7 +84,9 @@ private:
 private:
     std::string params_;
     void * proj_;
+    void * proj_ctx_;
     bool is_geographic_;
+    boost::optional<well_known_srs_e> well_known_;
 #ifdef MAPNIK_THREADSAFE
     static boost::mutex mutex_;
 #endif
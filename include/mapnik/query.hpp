@@ -76,6 +76,7 @@ public:
         return *this;
     }
          
+    // pixels per unit of the datasource srs, in x and y
     query::resolution_type const& resolution() const
     {
         return resolution_;
@@ -26,9 +26,11 @@
 #ifndef __TEXT_PATH_H__
 #define __TEXT_PATH_H__
 
+#include <mapnik/box2d.hpp>
 #include <boost/utility.hpp>
 #include <boost/shared_ptr.hpp>
 #include <unicode/unistr.h>
+#include <vector>
 
 namespace mapnik
 {
@@ -124,6 +126,9 @@ struct text_path : boost::noncopyable
     double starting_y;
     character_nodes_t nodes_;
     int itr_;
+    // character boxes the placement was tested for collisions with,
+    // only kept when placement::record_envelopes is set
+    std::vector<box2d<double> > envelopes;
           
     std::pair<unsigned,unsigned> string_dimensions;
         
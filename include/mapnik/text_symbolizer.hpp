@@ -104,6 +104,8 @@ struct MAPNIK_DECL text_symbolizer : public symbolizer_base
 
     expression_ptr get_orientation() const; // orienation (rotation angle atm)
     void set_orientation(expression_ptr expr);
+    expression_ptr get_priority() const; // labels with a priority are placed highest first at the end of the layer
+    void set_priority(expression_ptr expr);
          
     unsigned get_text_ratio() const; // target ratio for text bounding box in pixels
     void set_text_ratio(unsigned ratio);
@@ -165,6 +167,7 @@ struct MAPNIK_DECL text_symbolizer : public symbolizer_base
 private:
     expression_ptr name_;
     expression_ptr orientation_;
+    expression_ptr priority_;
     std::string face_name_;
     font_set fontset_;
     unsigned size_;
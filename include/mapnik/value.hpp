@@ -744,6 +744,11 @@ public:
         return base_;
     }
 
+    bool is_null() const
+    {
+        return boost::get<value_null>(&base_) != 0;
+    }
+
     bool to_bool() const
     {
         return boost::apply_visitor(impl::to_bool(),base_);
@@ -0,0 +1,252 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2006 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_VERTEX_FILTER_HPP
+#define MAPNIK_VERTEX_FILTER_HPP
+
+// mapnik
+#include <mapnik/vertex.hpp>
+#include <mapnik/enumeration.hpp>
+
+// stl
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace mapnik
+{
+
+enum simplify_algorithm_enum {
+    RADIAL_DISTANCE,
+    DOUGLAS_PEUCKER,
+    simplify_algorithm_enum_MAX
+};
+
+DEFINE_ENUM( simplify_algorithm_e, simplify_algorithm_enum );
+
+// squared distance of p to the segment a-b
+template <typename Point>
+double segment_distance2(Point const& p, Point const& a, Point const& b)
+{
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double len2 = dx * dx + dy * dy;
+    double t = 0.0;
+    if (len2 > 0.0)
+    {
+        t = ((p.x - a.x) * dx + (p.y - a.y) * dy) / len2;
+        t = std::max(0.0, std::min(1.0, t));
+    }
+    double ex = a.x + t * dx - p.x;
+    double ey = a.y + t * dy - p.y;
+    return ex * ex + ey * ey;
+}
+
+/** Douglas-Peucker over points[first..last]: marks in keep the points
+  * needed for the line through them to stay within sqrt(tolerance2) of
+  * every point, always including first and last. Other entries of keep
+  * are left alone. Uses an explicit stack, so long lines cannot overflow
+  * the call stack.
+  */
+template <typename Point>
+void douglas_peucker(std::vector<Point> const& points,
+                     std::size_t first, std::size_t last,
+                     double tolerance2, std::vector<char> & keep)
+{
+    keep[first] = keep[last] = 1;
+    std::vector<std::pair<std::size_t,std::size_t> > stack;
+    stack.push_back(std::make_pair(first,last));
+    while (!stack.empty())
+    {
+        std::size_t a = stack.back().first;
+        std::size_t b = stack.back().second;
+        stack.pop_back();
+        double max_d2 = 0.0;
+        std::size_t index = a;
+        for (std::size_t i = a + 1; i < b; ++i)
+        {
+            double d2 = segment_distance2(points[i], points[a], points[b]);
+            if (d2 > max_d2)
+            {
+                max_d2 = d2;
+                index = i;
+            }
+        }
+        if (max_d2 > tolerance2)
+        {
+            keep[index] = 1;
+            stack.push_back(std::make_pair(a,index));
+            stack.push_back(std::make_pair(index,b));
+        }
+    }
+}
+
+/** Drops vertices of a screen space path that are not visible at the
+  * given tolerance in pixels, before the path reaches the rasterizer.
+  *
+  * RADIAL_DISTANCE skips line_to vertices closer than the tolerance to
+  * the last vertex passed on, streaming and without allocation. The last
+  * vertex of every sub path is always passed on. DOUGLAS_PEUCKER reads
+  * the whole path on first access and keeps the vertices needed to stay
+  * within the tolerance of every sub path. A tolerance of 0 passes all
+  * vertices through unchanged.
+  */
+template <typename VertexSource>
+class vertex_filter
+{
+public:
+    vertex_filter(VertexSource & source, double tolerance,
+                  simplify_algorithm_e algorithm = RADIAL_DISTANCE)
+        : source_(source),
+          tolerance2_(tolerance * tolerance),
+          algorithm_(algorithm),
+          simplified_(false),
+          pos_(0),
+          has_pending_(false),
+          has_next_(false),
+          last_x_(0), last_y_(0) {}
+
+    void rewind(unsigned path_id)
+    {
+        source_.rewind(path_id);
+        pos_ = 0;
+        has_pending_ = false;
+        has_next_ = false;
+    }
+
+    unsigned vertex(double * x, double * y)
+    {
+        if (tolerance2_ <= 0.0) return source_.vertex(x,y);
+        if (algorithm_ == DOUGLAS_PEUCKER) return buffered_vertex(x,y);
+        if (has_next_)
+        {
+            has_next_ = false;
+            *x = next_.x;
+            *y = next_.y;
+            last_x_ = *x;
+            last_y_ = *y;
+            return next_.cmd;
+        }
+        for (;;)
+        {
+            unsigned cmd = source_.vertex(x,y);
+            if (cmd == SEG_LINETO)
+            {
+                double dx = *x - last_x_;
+                double dy = *y - last_y_;
+                if (dx * dx + dy * dy < tolerance2_)
+                {
+                    has_pending_ = true;
+                    pending_x_ = *x;
+                    pending_y_ = *y;
+                    continue;
+                }
+                has_pending_ = false;
+            }
+            else if (has_pending_)
+            {
+                // end of a sub path, emit its last vertex before cmd
+                has_pending_ = false;
+                has_next_ = true;
+                next_ = vertex_type(*x,*y,cmd);
+                *x = pending_x_;
+                *y = pending_y_;
+                cmd = SEG_LINETO;
+            }
+            last_x_ = *x;
+            last_y_ = *y;
+            return cmd;
+        }
+    }
+
+private:
+    struct vertex_type
+    {
+        vertex_type() : x(0), y(0), cmd(SEG_END) {}
+        vertex_type(double x_, double y_, unsigned cmd_) : x(x_), y(y_), cmd(cmd_) {}
+        double x;
+        double y;
+        unsigned cmd;
+    };
+
+    unsigned buffered_vertex(double * x, double * y)
+    {
+        if (!simplified_) simplify();
+        if (pos_ >= vertices_.size()) return SEG_END;
+        vertex_type const& v = vertices_[pos_++];
+        *x = v.x;
+        *y = v.y;
+        return v.cmd;
+    }
+
+    void simplify()
+    {
+        std::vector<vertex_type> path;
+        double x, y;
+        unsigned cmd;
+        while ((cmd = source_.vertex(&x,&y)) != SEG_END)
+        {
+            path.push_back(vertex_type(x,y,cmd));
+        }
+        std::vector<char> keep(path.size(), 1);
+        std::size_t first = 0;
+        while (first < path.size())
+        {
+            // a sub path is a move_to followed by line_tos
+            std::size_t last = first;
+            while (last + 1 < path.size() && path[last + 1].cmd == SEG_LINETO) ++last;
+            if (last > first + 1)
+            {
+                std::fill(keep.begin() + first + 1, keep.begin() + last, 0);
+                douglas_peucker(path, first, last, tolerance2_, keep);
+            }
+            first = last + 1;
+        }
+        vertices_.clear();
+        for (std::size_t i = 0; i < path.size(); ++i)
+        {
+            if (keep[i]) vertices_.push_back(path[i]);
+        }
+        simplified_ = true;
+        pos_ = 0;
+    }
+
+    VertexSource & source_;
+    double tolerance2_;
+    simplify_algorithm_e algorithm_;
+    std::vector<vertex_type> vertices_;
+    bool simplified_;
+    std::size_t pos_;
+    bool has_pending_;
+    bool has_next_;
+    vertex_type next_;
+    double last_x_;
+    double last_y_;
+    double pending_x_;
+    double pending_y_;
+};
+
+}
+
+#endif // MAPNIK_VERTEX_FILTER_HPP
@@ -32,12 +32,15 @@
 // mapnik
 #include <mapnik/vertex.hpp>
 #include <mapnik/ctrans.hpp>
+#include <mapnik/arena.hpp>
 // boost
 #include <boost/utility.hpp>
 #include <boost/tuple/tuple.hpp>
+#include <boost/iterator/iterator_facade.hpp>
 // stl
 #include <vector>
 #include <cstring>
+#include <cstddef>
 
 namespace mapnik
 {
@@ -139,47 +142,98 @@ private:
     }
 };
 
+/** Vertex storage as structure of arrays: x and y coordinates in two
+  * contiguous arrays and the commands in a byte stream, 17 bytes per
+  * vertex instead of the 24 of a padded (x,y,cmd) tuple. Reading is
+  * stateless, get_vertex() and the iterators can be used concurrently.
+  */
 template <typename T>
 struct vertex_vector2 //: boost::noncopyable
 {
     typedef typename T::type value_type;
     typedef boost::tuple<value_type,value_type,char> vertex_type;
-    typedef typename std::vector<vertex_type>::const_iterator const_iterator;
+
+    class const_iterator
+        : public boost::iterator_facade<const_iterator,
+                                        vertex_type const,
+                                        boost::random_access_traversal_tag,
+                                        vertex_type const>
+    {
+    public:
+        const_iterator()
+            : cont_(0),
+              pos_(0) {}
+
+        const_iterator(vertex_vector2 const* cont, unsigned pos)
+            : cont_(cont),
+              pos_(pos) {}
+
+    private:
+        friend class boost::iterator_core_access;
+
+        vertex_type const dereference() const
+        {
+            return vertex_type(cont_->xs_[pos_],cont_->ys_[pos_],cont_->cmds_[pos_]);
+        }
+
+        bool equal(const_iterator const& other) const
+        {
+            return pos_ == other.pos_;
+        }
+
+        void increment() { ++pos_; }
+        void decrement() { --pos_; }
+        void advance(std::ptrdiff_t n) { pos_ += n; }
+
+        std::ptrdiff_t distance_to(const_iterator const& other) const
+        {
+            return std::ptrdiff_t(other.pos_) - std::ptrdiff_t(pos_);
+        }
+
+        vertex_vector2 const* cont_;
+        unsigned pos_;
+    };
+
     vertex_vector2() {}
     unsigned size() const 
     {
-        return cont_.size();
+        return cmds_.size();
     }
 
     void push_back (value_type x,value_type y,unsigned command)
     {
-        cont_.push_back(vertex_type(x,y,command));
+        xs_.push_back(x);
+        ys_.push_back(y);
+        cmds_.push_back(static_cast<unsigned char>(command));
     }
     unsigned get_vertex(unsigned pos,value_type* x,value_type* y) const
     {
-        if (pos >= cont_.size()) return SEG_END;
-        vertex_type const& c = cont_[pos];
-        *x = boost::get<0>(c);
-        *y = boost::get<1>(c);
-        return boost::get<2>(c);
+        if (pos >= cmds_.size()) return SEG_END;
+        *x = xs_[pos];
+        *y = ys_[pos];
+        return cmds_[pos];
     }
         
     const_iterator begin() const
     {
-        return cont_.begin();
+        return const_iterator(this,0);
     }
         
     const_iterator end() const
     {
-        return cont_.end();
+        return const_iterator(this,cmds_.size());
     }
 
     void set_capacity(size_t size)
     {
-        cont_.reserve(size);
+        xs_.reserve(size);
+        ys_.reserve(size);
+        cmds_.reserve(size);
     }
 private:
-    std::vector<vertex_type> cont_;
+    std::vector<value_type,arena_allocator<value_type> > xs_;
+    std::vector<value_type,arena_allocator<value_type> > ys_;
+    std::vector<unsigned char,arena_allocator<unsigned char> > cmds_;
 };
 }
 
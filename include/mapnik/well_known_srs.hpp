@@ -0,0 +1,126 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_WELL_KNOWN_SRS_HPP
+#define MAPNIK_WELL_KNOWN_SRS_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+// boost
+#include <boost/optional.hpp>
+// stl
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <string>
+
+namespace mapnik {
+
+/** Projections proj_transform handles with closed-form kernels
+  * instead of going through PROJ.
+  */
+enum well_known_srs_e {
+    WGS_84,      // +proj=longlat +datum=WGS84
+    G_MERC,      // spherical ("google") mercator, +nadgrids=@null
+    G_MERC_OVER  // spherical mercator with +over (no longitude wrapping)
+};
+
+/** Detects WGS84 and spherical mercator from a PROJ.4 definition.
+  * Only definitions without any additional parameters match, so the
+  * kernels below give the same results as PROJ would.
+  */
+MAPNIK_DECL boost::optional<well_known_srs_e> is_well_known_srs(std::string const& srs);
+
+namespace merc_detail {
+
+static const double EARTH_RADIUS = 6378137.0;
+static const double PI = 3.14159265358979323846;
+static const double HALF_PI = PI / 2.0;
+static const double QUARTER_PI = PI / 4.0;
+static const double DEG_TO_RAD = PI / 180.0;
+static const double RAD_TO_DEG = 180.0 / PI;
+static const double EPS10 = 1.0e-10;
+
+// mirrors adjlon() of PROJ
+inline double adjlon(double lon)
+{
+    if (std::fabs(lon) <= 3.14159265359) return lon;
+    lon += PI;
+    lon -= 2.0 * PI * std::floor(lon / (2.0 * PI));
+    lon -= PI;
+    return lon;
+}
+}
+
+/** Transforms WGS84 degrees into spherical mercator meters in place.
+  * Points PROJ cannot project (the poles) are set to HUGE_VAL.
+  * Like pj_transform only a single failing point is reported as error.
+  */
+inline bool lonlat2merc(double * x, double * y, std::size_t point_count, std::size_t stride, bool wrap)
+{
+    using namespace merc_detail;
+    bool ok = true;
+    for (std::size_t i = 0; i < point_count * stride; i += stride)
+    {
+        double lam = x[i] * DEG_TO_RAD;
+        double phi = y[i] * DEG_TO_RAD;
+        if (std::fabs(lam) > 10.0 || std::fabs(std::fabs(phi) - HALF_PI) <= EPS10
+            || std::fabs(phi) > HALF_PI)
+        {
+            x[i] = HUGE_VAL;
+            y[i] = HUGE_VAL;
+            ok = false;
+            continue;
+        }
+        if (wrap) lam = adjlon(lam);
+        x[i] = EARTH_RADIUS * lam;
+        y[i] = EARTH_RADIUS * std::log(std::tan(QUARTER_PI + 0.5 * phi));
+    }
+    return ok || point_count > 1;
+}
+
+/** Transforms spherical mercator meters into WGS84 degrees in place.
+  */
+inline bool merc2lonlat(double * x, double * y, std::size_t point_count, std::size_t stride, bool wrap)
+{
+    using namespace merc_detail;
+    bool ok = true;
+    for (std::size_t i = 0; i < point_count * stride; i += stride)
+    {
+        if (x[i] == HUGE_VAL || y[i] == HUGE_VAL)
+        {
+            ok = false;
+            continue;
+        }
+        double lam = x[i] / EARTH_RADIUS;
+        double phi = HALF_PI - 2.0 * std::atan(std::exp(-y[i] / EARTH_RADIUS));
+        if (wrap) lam = adjlon(lam);
+        x[i] = lam * RAD_TO_DEG;
+        y[i] = phi * RAD_TO_DEG;
+    }
+    return ok || point_count > 1;
+}
+}
+
+#endif // MAPNIK_WELL_KNOWN_SRS_HPP
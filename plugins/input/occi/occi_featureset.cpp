@@ -118,7 +118,7 @@ feature_ptr occi_featureset::next()
            case oracle::occi::OCCIINT:
            case oracle::occi::OCCIUNSIGNED_INT:
            {
-              boost::put(*feature,fld_name,rs_->getInt (i + 1));
+              feature->put(fld_name,rs_->getInt (i + 1));
               break;
            }
            
@@ -129,7 +129,7 @@ feature_ptr occi_featureset::next()
            case oracle::occi::OCCINUMBER:
            case oracle::occi::OCCI_SQLT_NUM:
            {
-              boost::put(*feature,fld_name,rs_->getDouble (i + 1));
+              feature->put(fld_name,rs_->getDouble (i + 1));
               break;
            }
 
@@ -147,7 +147,7 @@ feature_ptr occi_featureset::next()
            case oracle::occi::OCCI_SQLT_RDD:
            {
               UnicodeString ustr = tr_->transcode (rs_->getString (i + 1).c_str());
-              boost::put(*feature,fld_name,ustr);
+              feature->put(fld_name,ustr);
               break;
            }
            
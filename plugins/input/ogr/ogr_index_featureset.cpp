@@ -123,13 +123,13 @@ feature_ptr ogr_index_featureset<filterT>::next()
                   {
                    case OFTInteger:
                    {
-                       boost::put(*feature,fld_name,(*feat)->GetFieldAsInteger (i));
+                       feature->put(fld_name,(*feat)->GetFieldAsInteger (i));
                        break;
                    }
 
                    case OFTReal:
                    {
-                       boost::put(*feature,fld_name,(*feat)->GetFieldAsDouble (i));
+                       feature->put(fld_name,(*feat)->GetFieldAsDouble (i));
                        break;
                    }
                            
@@ -137,7 +137,7 @@ feature_ptr ogr_index_featureset<filterT>::next()
                    case OFTWideString:     // deprecated !
                    {
                        UnicodeString ustr = tr_->transcode((*feat)->GetFieldAsString (i));
-                       boost::put(*feature,fld_name,ustr);
+                       feature->put(fld_name,ustr);
                        break;
                    }
 
@@ -157,7 +157,7 @@ feature_ptr ogr_index_featureset<filterT>::next()
 #ifdef MAPNIK_DEBUG
                        clog << "unhandled type_oid=" << type_oid << endl;
 #endif
-                       //boost::put(*feature,name,feat->GetFieldAsBinary (i, size));
+                       //feature->put(name,feat->GetFieldAsBinary (i, size));
                        break;
                    }
                        
@@ -106,6 +106,7 @@ class postgis_featureset : public mapnik::Featureset
       bool multiple_geometries_;
       unsigned num_attrs_;
       boost::scoped_ptr<mapnik::transcoder> tr_;
+      mapnik::context_ptr ctx_;
       mutable int totalGeomSize_;
       mutable int count_;
    public:
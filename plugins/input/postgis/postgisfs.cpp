@@ -155,6 +155,7 @@ postgis_featureset::postgis_featureset(boost::shared_ptr<IResultSet> const& rs,
       multiple_geometries_(multiple_geometries),
       num_attrs_(num_attrs),
       tr_(new transcoder(encoding)),
+      ctx_(new mapnik::context),
       totalGeomSize_(0),
       count_(0)  {}
 
@@ -162,7 +163,7 @@ feature_ptr postgis_featureset::next()
 {
     if (rs_->next())
     { 
-        feature_ptr feature(new Feature(count_));
+        feature_ptr feature(new Feature(ctx_,count_));
         int size=rs_->getFieldLength(0);
         const char *data = rs_->getValue(0);
         geometry_utils::from_wkb(*feature,data,size,multiple_geometries_);
@@ -179,44 +180,44 @@ feature_ptr postgis_featureset::next()
            
               if (oid==16) //bool
               {
-                 boost::put(*feature,name,buf[0] != 0);
+                 feature->put(name,buf[0] != 0);
               }
               else if (oid==23) //int4
               {
                  int val = int4net(buf);
-                 boost::put(*feature,name,val);
+                 feature->put(name,val);
               }
               else if (oid==21) //int2
               {
                  int val = int2net(buf);
-                 boost::put(*feature,name,val);
+                 feature->put(name,val);
               }
               else if (oid==20) //int8/BigInt
               {
                  int val = int8net(buf);
-                 boost::put(*feature,name,val);
+                 feature->put(name,val);
               }
               else if (oid == 700) // float4
               {
                  float val;
                  float4net(val,buf);
-                 boost::put(*feature,name,val);
+                 feature->put(name,val);
               }
               else if (oid == 701) // float8
               {
                  double val;
                  float8net(val,buf);
-                 boost::put(*feature,name,val);
+                 feature->put(name,val);
               }
               else if (oid==25 || oid==1043) // text or varchar
               {
                  UnicodeString ustr = tr_->transcode(buf);
-                 boost::put(*feature,name,ustr);
+                 feature->put(name,ustr);
               }
               else if (oid==1042)
               {
                  UnicodeString ustr = tr_->transcode(trim_copy(string(buf)).c_str()); // bpchar
-                 boost::put(*feature,name,ustr);
+                 feature->put(name,ustr);
               }
               else if (oid == 1700) // numeric
               {
@@ -224,7 +225,7 @@ feature_ptr postgis_featureset::next()
                  try 
                  {
                     double val = boost::lexical_cast<double>(str);
-                    boost::put(*feature,name,val);
+                    feature->put(name,val);
                  }
                  catch (boost::bad_lexical_cast & ex)
                  {
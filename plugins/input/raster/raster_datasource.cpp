@@ -105,6 +105,11 @@ int raster_datasource::type() const
     return datasource::Raster;
 }
 
+bool raster_datasource::thread_safe() const
+{
+    return true;
+}
+
 std::string raster_datasource::name_="raster";
 std::string raster_datasource::name()
 {
@@ -42,6 +42,7 @@ public:
    raster_datasource(const mapnik::parameters& params);
    virtual ~raster_datasource();
    int type() const;
+   bool thread_safe() const;
    static std::string name();
    mapnik::featureset_ptr features(const mapnik::query& q) const;
    mapnik::featureset_ptr features_at_point(mapnik::coord2d const& pt) const;
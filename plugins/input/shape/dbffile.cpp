@@ -30,46 +30,106 @@
 
 // stl
 #include <string>
+#include <cstring>
+#include <algorithm>
 
 
 dbf_file::dbf_file()
     : num_records_(0),
       num_fields_(0),
       record_length_(0),
+      data_(0),
+      size_(0),
+      pos_(0),
       record_(0) {}
 
 dbf_file::dbf_file(std::string const& file_name)
     :num_records_(0),
      num_fields_(0),
      record_length_(0),
+     data_(0),
+     size_(0),
+     pos_(0),
+     record_(0)
+{
 #ifdef SHAPE_MEMORY_MAPPED_FILE
-     file_(file_name),
+    open(file_name, true);
 #else
-     file_(file_name,std::ios::in | std::ios::binary),
+    open(file_name, false);
 #endif
+}
+
+dbf_file::dbf_file(std::string const& file_name, bool memory_mapped)
+    :num_records_(0),
+     num_fields_(0),
+     record_length_(0),
+     data_(0),
+     size_(0),
+     pos_(0),
      record_(0)
 {
-    if (file_.is_open())
+    open(file_name, memory_mapped);
+}
+
+dbf_file::dbf_file(std::string const& file_name, mapped_file_source const& mapping)
+    :num_records_(0),
+     num_fields_(0),
+     record_length_(0),
+     mapping_(mapping),
+     data_(0),
+     size_(0),
+     pos_(0),
+     record_(0)
+{
+    if (mapping_.is_open())
     {
+        data_ = mapping_.data();
+        size_ = mapping_.size();
         read_header();
     }
+    else
+    {
+        open(file_name, false);
+    }
 }
 
-
-dbf_file::~dbf_file()
+void dbf_file::open(std::string const& file_name, bool memory_mapped)
 {
-    ::operator delete(record_);
+    if (memory_mapped)
+    {
+        try
+        {
+            mapping_.open(file_name);
+            data_ = mapping_.data();
+            size_ = mapping_.size();
+        }
+        catch (...) {}
+    }
+    else
+    {
+        file_.open(file_name,std::ios::in | std::ios::binary);
+        if (file_.is_open() && !file_->is_open()) file_.close();
+    }
+    if (is_open())
+    {
+        read_header();
+    }
 }
 
+dbf_file::~dbf_file() {}
+
 
 bool dbf_file::is_open()
 {
-    return file_.is_open();
+    return data_ != 0 || file_.is_open();
 }
 
 
 void dbf_file::close()
 {
+    data_ = 0;
+    size_ = 0;
+    mapping_ = mapped_file_source();
     if (file_ && file_.is_open())
         file_.close();
 }
@@ -92,8 +152,23 @@ void dbf_file::move_to(int index)
     if (index>0 && index<=num_records_)
     {
         stream_offset pos=(num_fields_<<5)+34+(index-1)*(record_length_+1);
-        file_.seekg(pos,std::ios::beg);
-        file_.read(record_,record_length_);
+        if (data_)
+        {
+            if (pos + record_length_ <= stream_offset(size_))
+            {
+                record_ = data_ + pos;
+                return;
+            }
+        }
+        else
+        {
+            file_.seekg(pos,std::ios::beg);
+            if (file_.read(&buffer_[0],record_length_)) return;
+            file_.clear();
+        }
+        // a truncated file reads as empty fields rather than the previous record
+        std::fill(buffer_.begin(), buffer_.end(), ' ');
+        record_ = &buffer_[0];
     }
 }
 
@@ -115,61 +190,80 @@ const field_descriptor& dbf_file::descriptor(int col) const
 }
 
 
-void dbf_file::add_attribute(int col, mapnik::transcoder const& tr, Feature const& f) const throw()
+void dbf_file::add_attribute(int col, mapnik::transcoder const& tr, Feature & f) const throw()
+{
+    if (col>=0 && col<num_fields_)
+    {
+        decode(fields_[col], record_, tr, f[fields_[col].name_]);
+    }
+}
+
+bool dbf_file::is_memory_mapped() const
+{
+    return data_ != 0;
+}
+
+mapped_file_source const& dbf_file::mapping() const
+{
+    return mapping_;
+}
+
+const char* dbf_file::record() const
+{
+    return record_;
+}
+
+void dbf_file::decode(field_descriptor const& fd, const char* record,
+                      mapnik::transcoder const& tr, mapnik::value & v)
 {
     using namespace boost::spirit;
 
-    if (col>=0 && col<num_fields_)
+    switch (fd.type_)
     {
-        std::string name=fields_[col].name_;
-        
-        switch (fields_[col].type_)
-        {
-        case 'C':
-        case 'D'://todo handle date?
-        case 'M':
-        case 'L':
+    case 'C':
+    case 'D'://todo handle date?
+    case 'M':
+    case 'L':
+    {
+        // FIXME - avoid constructing std::string in stack
+        std::string str(record+fd.offset_,fd.length_);
+        boost::trim(str); 
+        v = tr.transcode(str.c_str()); 
+        break;
+    }
+    case 'N':
+    case 'F':
+    {
+            
+        if (record[fd.offset_] == '*')
         {
-            // FIXME - avoid constructing std::string in stack
-            std::string str(record_+fields_[col].offset_,fields_[col].length_);
-            boost::trim(str); 
-            f[name] = tr.transcode(str.c_str()); 
+            v = 0;
             break;
         }
-        case 'N':
-        case 'F':
-        {
-            
-            if (record_[fields_[col].offset_] == '*')
-            {
-                boost::put(f,name,0);
-                break;
-            }
-            if ( fields_[col].dec_>0 )
-            {   
-                double val = 0.0;
-                const char *itr = record_+fields_[col].offset_;
-                const char *end = itr + fields_[col].length_;
-                qi::phrase_parse(itr,end,double_,ascii::space,val);
-                boost::put(f,name,val); 
-            }
-            else
-            {
-                int val = 0; 
-                const char *itr = record_+fields_[col].offset_;
-                const char *end = itr + fields_[col].length_;
-                qi::phrase_parse(itr,end,int_,ascii::space,val);
-                boost::put(f,name,val); 
-            }
-            break;
+        if ( fd.dec_>0 )
+        {   
+            double val = 0.0;
+            const char *itr = record+fd.offset_;
+            const char *end = itr + fd.length_;
+            qi::phrase_parse(itr,end,double_,ascii::space,val);
+            v = val; 
         }
+        else
+        {
+            int val = 0; 
+            const char *itr = record+fd.offset_;
+            const char *end = itr + fd.length_;
+            qi::phrase_parse(itr,end,int_,ascii::space,val);
+            v = val; 
         }
+        break;
+    }
     }
 }
 
 void dbf_file::read_header()
 {
-    char c=file_.get();
+    char c=get();
     if (c=='\3' || c=='\131')
     {
         skip(3);
@@ -187,13 +281,13 @@ void dbf_file::read_header()
         {
             field_descriptor desc;
             desc.index_=i;
-            file_.read(name,10);
+            read(name,10);
             desc.name_=boost::trim_left_copy(std::string(name));
             skip(1);
-            desc.type_=file_.get();
+            desc.type_=get();
             skip(4);
-            desc.length_=file_.get();
-            desc.dec_=file_.get();
+            desc.length_=get();
+            desc.dec_=get();
             skip(14);
             desc.offset_=offset;
             offset+=desc.length_;
@@ -202,16 +296,41 @@ void dbf_file::read_header()
         record_length_=offset;
         if (record_length_>0)
         {
-            record_=static_cast<char*>(::operator new (sizeof(char)*record_length_));
+            buffer_.resize(record_length_,' ');
+            record_=&buffer_[0];
         }
     }
 }
 
 
+void dbf_file::read(char* buf, std::size_t n)
+{
+    if (data_)
+    {
+        std::size_t avail = pos_ < size_ ? size_ - pos_ : 0;
+        if (n > avail) n = avail;
+        std::memcpy(buf, data_ + pos_, n);
+        pos_ += n;
+    }
+    else
+    {
+        file_.read(buf, n);
+    }
+}
+
+
+char dbf_file::get()
+{
+    char c = 0;
+    read(&c,1);
+    return c;
+}
+
+
 int dbf_file::read_short()
 {
     char b[2];
-    file_.read(b,2);
+    read(b,2);
     boost::int16_t val;
     mapnik::read_int16_ndr(b,val);
     return val;
@@ -221,7 +340,7 @@ int dbf_file::read_short()
 int dbf_file::read_int()
 {    
     char b[4];
-    file_.read(b,4);
+    read(b,4);
     boost::int32_t val;
     mapnik::read_int32_ndr(b,val);
     return val;
@@ -229,5 +348,32 @@ int dbf_file::read_int()
 
 void dbf_file::skip(int bytes)
 {
-    file_.seekg(bytes,std::ios::cur);
+    if (data_) pos_ += bytes;
+    else file_.seekg(bytes,std::ios::cur);
+}
+
+dbf_lazy_attributes::dbf_lazy_attributes(mapped_file_source const& mapping,
+                                         std::string const& encoding)
+    : mapping_(mapping),
+      tr_(encoding) {}
+
+void dbf_lazy_attributes::add(std::size_t index, field_descriptor const& fd)
+{
+    if (index >= fields_.size()) fields_.resize(index + 1);
+    fields_[index] = fd;
+}
+
+void dbf_lazy_attributes::decode(std::size_t index, const char* record, mapnik::value & v) const
+{
+    if (index < fields_.size())
+    {
+        try
+        {
+            dbf_file::decode(fields_[index], record, tr_, v);
+        }
+        catch (...)
+        {
+            std::clog << "error processing attributes " << std::endl;
+        }
+    }
 }
@@ -24,6 +24,7 @@
 #define DBFFILE_HPP
 
 #include <mapnik/feature.hpp>
+#include <mapnik/unicode.hpp>
 // boost
 #include <boost/iostreams/stream.hpp>
 #include <boost/iostreams/device/file.hpp>
@@ -56,15 +57,19 @@ private:
     int num_fields_;
     stream_offset record_length_;
     std::vector<field_descriptor> fields_;
-#ifdef SHAPE_MEMORY_MAPPED_FILE
-    stream<mapped_file_source> file_;
-#else
+    // memory mapped files are read in place, records point into the mapping
+    mapped_file_source mapping_;
+    const char* data_;
+    std::size_t size_;
+    std::size_t pos_;
     stream<file_source> file_;
-#endif
-    char* record_;
+    std::vector<char> buffer_;
+    const char* record_;
 public:
     dbf_file();
     dbf_file(const std::string& file_name);
+    dbf_file(const std::string& file_name, bool memory_mapped);
+    dbf_file(const std::string& file_name, mapped_file_source const& mapping);
     ~dbf_file();
     bool is_open();
     void close();
@@ -73,14 +78,41 @@ public:
     field_descriptor const& descriptor(int col) const;
     void move_to(int index);
     std::string string_value(int col) const;
-    void add_attribute(int col, transcoder const& tr, Feature const& f) const throw();
+    void add_attribute(int col, transcoder const& tr, Feature & f) const throw();
+    bool is_memory_mapped() const;
+    mapped_file_source const& mapping() const;
+    // the current record, points into the mapping if memory mapped
+    const char* record() const;
+    static void decode(field_descriptor const& fd, const char* record,
+                       transcoder const& tr, mapnik::value & v);
 private:
     dbf_file(const dbf_file&);
     dbf_file& operator=(const dbf_file&);
+    void open(const std::string& file_name, bool memory_mapped);
     void read_header();
+    void read(char* buf, std::size_t n);
+    char get();
     int read_short();
     int read_int();
     void skip(int bytes);
 };
 
+/** Decodes attributes straight out of the memory mapped records of a DBF
+ *  file, when a feature attribute is first read. Holds on to the mapping
+ *  so features stay valid after the featureset and datasource are gone.
+ *  Features serialize decode() calls, which share one transcoder.
+ */
+class dbf_lazy_attributes : public mapnik::lazy_attributes
+{
+public:
+    dbf_lazy_attributes(mapped_file_source const& mapping, std::string const& encoding);
+    // decode field fd into the attribute in slot index
+    void add(std::size_t index, field_descriptor const& fd);
+    void decode(std::size_t index, const char* record, mapnik::value & v) const;
+private:
+    mapped_file_source mapping_;
+    transcoder tr_;
+    std::vector<field_descriptor> fields_;
+};
+
 #endif //DBFFILE_HPP
@@ -24,6 +24,7 @@
 #include <fstream>
 #include <stdexcept>
 #include <mapnik/geom_util.hpp>
+#include <mapnik/ptree_helpers.hpp>
 
 // boost
 #include <boost/version.hpp>
@@ -76,11 +77,28 @@ shape_datasource::shape_datasource(const parameters &params)
 
     try
     {  
-        shape_ = boost::shared_ptr<shape_io>(new shape_io(shape_name_));
-        init(*shape_);
-        for (int i=0;i<shape_->dbf().num_fields();++i)
+#ifdef SHAPE_MEMORY_MAPPED_FILE
+        bool memory_mapped = *params.get<mapnik::boolean>("memory_mapped",true);
+#else
+        bool memory_mapped = *params.get<mapnik::boolean>("memory_mapped",false);
+#endif
+        source_ = boost::shared_ptr<shape_source>(new shape_source(shape_name_,memory_mapped));
+        shape_io shape(*source_);
+        init(shape);
+        if (indexed_ && *params.get<mapnik::boolean>("packed_index",false))
+        {
+            source_->packed_index = boost::shared_ptr<shp_packed_index>(new shp_packed_index(*shape.index()));
+        }
+        // a missing or outdated .generalized file is built right here,
+        // creating the datasource blocks until it is written
+        int generalize_levels = *params.get<int>("generalize_levels",8);
+        if (*params.get<mapnik::boolean>("generalize",false) && generalize_levels > 0)
         {
-            field_descriptor const& fd=shape_->dbf().descriptor(i);
+            init_generalized(generalize_levels);
+        }
+        for (int i=0;i<shape.dbf().num_fields();++i)
+        {
+            field_descriptor const& fd=shape.dbf().descriptor(i);
             std::string fld_name=fd.name_;
             switch (fd.type_)
             {
@@ -190,11 +208,47 @@ void  shape_datasource::init(shape_io& shape)
 
 }
 
+void shape_datasource::init_generalized(unsigned levels)
+{
+    std::string shp_name = shape_name_ + shape_io::SHP;
+    std::string name = shape_name_ + shape_io::GENERALIZED;
+    boost::uint64_t shp_size = boost::filesystem::file_size(shp_name);
+    try
+    {
+        // reuse the file written by an earlier run if it is still current
+        if (boost::filesystem::exists(name) &&
+            boost::filesystem::last_write_time(name) >= boost::filesystem::last_write_time(shp_name))
+        {
+            try
+            {
+                boost::shared_ptr<shp_generalized> generalized(new shp_generalized(name, shp_size));
+                if (generalized->num_levels() == levels)
+                {
+                    source_->generalized = generalized;
+                    return;
+                }
+            }
+            catch (datasource_exception const&) {}
+        }
+        shp_generalized::build(*source_, name, extent_, levels);
+        source_->generalized = boost::shared_ptr<shp_generalized>(new shp_generalized(name, shp_size));
+    }
+    catch (std::exception const& ex)
+    {
+        std::cerr << "Shape Plugin Warning: Could not use generalized geometries '" << name << "': " << ex.what() << "\n";
+    }
+}
+
 int shape_datasource::type() const
 {
     return type_;
 }
 
+bool shape_datasource::thread_safe() const
+{
+    return true;
+}
+
 layer_descriptor shape_datasource::get_descriptor() const
 {
     return desc_;
@@ -208,23 +262,29 @@ std::string shape_datasource::name()
 featureset_ptr shape_datasource::features(const query& q) const
 {
     filter_in_box filter(q.get_bbox());
+    int level = -1;
+    if (source_->generalized)
+    {
+        level = source_->generalized->level(boost::get<0>(q.resolution()));
+    }
     if (indexed_)
     {
-        shape_->shp().seek(0);
         return featureset_ptr
             (new shape_index_featureset<filter_in_box>(filter,
-                                                       *shape_,
+                                                       *source_,
                                                        q.property_names(),
-                                                       desc_.get_encoding()));
+                                                       desc_.get_encoding(),
+                                                       level));
     }
     else
     {
         return featureset_ptr
             (new shape_featureset<filter_in_box>(filter,
-                                                 shape_name_,
+                                                 *source_,
                                                  q.property_names(),
                                                  desc_.get_encoding(),
-                                                 file_length_));
+                                                 file_length_,
+                                                 level));
     }
 }
 
@@ -247,18 +307,20 @@ featureset_ptr shape_datasource::features_at_point(coord2d const& pt) const
     {
         return featureset_ptr
             (new shape_index_featureset<filter_at_point>(filter,
-                                                         *shape_,
+                                                         *source_,
                                                          names,
-                                                         desc_.get_encoding()));
+                                                         desc_.get_encoding(),
+                                                         -1));
     }
     else
     {
         return featureset_ptr
             (new shape_featureset<filter_at_point>(filter,
-                                                   shape_name_,
+                                                   *source_,
                                                    names,
                                                    desc_.get_encoding(),
-                                                   file_length_));
+                                                   file_length_,
+                                                   -1));
     }
 }
 
@@ -46,6 +46,7 @@ public:
     virtual ~shape_datasource();
     
     int type() const;
+    bool thread_safe() const;
     static std::string name();
     featureset_ptr features(const query& q) const;
     featureset_ptr features_at_point(coord2d const& pt) const;
@@ -55,10 +56,11 @@ private:
     shape_datasource(const shape_datasource&);
     shape_datasource& operator=(const shape_datasource&);
     void init(shape_io& shape);
+    void init_generalized(unsigned levels);
 private:
     int type_;
     std::string shape_name_;
-    boost::shared_ptr<shape_io> shape_;
+    boost::shared_ptr<shape_source> source_;
     long file_length_;
     box2d<double> extent_;
     bool indexed_;
@@ -26,19 +26,31 @@
 
 template <typename filterT>
 shape_featureset<filterT>::shape_featureset(const filterT& filter, 
-                                            const std::string& shape_file,
+                                            shape_source const& source,
                                             const std::set<std::string>& attribute_names,
                                             std::string const& encoding,
-                                            long file_length )
+                                            long file_length,
+                                            int generalization_level)
     : filter_(filter),
       shape_type_(shape_io::shape_null),
-      shape_(shape_file),
+      shape_(source),
       query_ext_(),
       tr_(new transcoder(encoding)),
       file_length_(file_length),
+      lazy_slots_(0),
+      ctx_(new mapnik::context),
       count_(0)
 {
     shape_.shp().skip(100);
+    shape_.set_generalization_level(generalization_level);
+    // attributes of a memory mapped dbf are decoded on first access
+    dbf_lazy_attributes * lazy = 0;
+    if (shape_.dbf().is_memory_mapped())
+    {
+        lazy = new dbf_lazy_attributes(shape_.dbf().mapping(), encoding);
+        lazy_.reset(lazy);
+    }
+
     //attributes
     typename std::set<std::string>::const_iterator pos=attribute_names.begin();
     while (pos!=attribute_names.end())
@@ -48,7 +60,16 @@ shape_featureset<filterT>::shape_featureset(const filterT& filter,
         {
             if (shape_.dbf().descriptor(i).name_ == *pos)
             {
-                attr_ids_.push_back(i);
+                std::size_t index = ctx_->push(*pos);
+                if (lazy && index < Feature::max_lazy_slots)
+                {
+                    lazy->add(index, shape_.dbf().descriptor(i));
+                    lazy_slots_ |= boost::uint64_t(1) << index;
+                }
+                else
+                {
+                    attr_ids_.push_back(i);
+                }
                 found_name = true;
                 break;
             }
@@ -81,7 +102,7 @@ feature_ptr shape_featureset<filterT>::next()
     {
         shape_.move_to(pos);
         int type=shape_.type();
-        feature_ptr feature(new Feature(shape_.id_));
+        feature_ptr feature(new Feature(ctx_,shape_.id_));
         if (type == shape_io::shape_point)
         {
             double x=shape_.shp().read_double();
@@ -240,9 +261,13 @@ feature_ptr shape_featureset<filterT>::next()
     
             }
         }
-        if (attr_ids_.size())
+        if (lazy_slots_ || attr_ids_.size())
         {
             shape_.dbf().move_to(shape_.id_);
+            if (lazy_slots_)
+            {
+                feature->set_lazy_attributes(lazy_, shape_.dbf().record(), lazy_slots_);
+            }
             std::vector<int>::const_iterator pos=attr_ids_.begin();
             std::vector<int>::const_iterator end=attr_ids_.end();
              
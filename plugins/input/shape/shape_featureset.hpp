@@ -41,15 +41,19 @@ class shape_featureset : public Featureset
       boost::scoped_ptr<transcoder> tr_;
       long file_length_;
       std::vector<int> attr_ids_;
+      mapnik::lazy_attributes_ptr lazy_;
+      boost::uint64_t lazy_slots_;
+      mapnik::context_ptr ctx_;
       mutable box2d<double> feature_ext_;
       mutable int total_geom_size;
       mutable int count_;
    public:
       shape_featureset(const filterT& filter, 
-                       const std::string& shape_file,
+                       shape_source const& source,
                        const std::set<std::string>& attribute_names,
                        std::string const& encoding,
-                       long file_length);
+                       long file_length,
+                       int generalization_level);
       virtual ~shape_featureset();
       feature_ptr next();
    private:
@@ -32,21 +32,29 @@ using namespace boost::iostreams;
 
 template <typename filterT>
 shape_index_featureset<filterT>::shape_index_featureset(const filterT& filter,
-                                                        shape_io& shape,
+                                                        shape_source const& source,
                                                         const std::set<std::string>& attribute_names,
-                                                        std::string const& encoding)
+                                                        std::string const& encoding,
+                                                        int generalization_level)
     : filter_(filter),
       shape_type_(0),
-      shape_(shape),
+      shape_(source),
       tr_(new transcoder(encoding)),
+      lazy_slots_(0),
+      ctx_(new mapnik::context),
       count_(0)
 
 {
     shape_.shp().skip(100);
+    shape_.set_generalization_level(generalization_level);
     boost::shared_ptr<shape_file> index = shape_.index();
-    if (index)
+    if (source.packed_index)
     {
-        shp_index<filterT,stream<mapped_file_source> >::query(filter,index->file(),ids_);
+        source.packed_index->query(filter,ids_);
+    }
+    else if (index)
+    {
+        shp_index<filterT>::query(filter,*index,ids_);
     }
     std::sort(ids_.begin(),ids_.end());    
     
@@ -56,6 +64,14 @@ shape_index_featureset<filterT>::shape_index_featureset(const filterT& filter,
 
     itr_ = ids_.begin();
 
+    // attributes of a memory mapped dbf are decoded on first access
+    dbf_lazy_attributes * lazy = 0;
+    if (shape_.dbf().is_memory_mapped())
+    {
+        lazy = new dbf_lazy_attributes(shape_.dbf().mapping(), encoding);
+        lazy_.reset(lazy);
+    }
+
     // deal with attributes
     std::set<std::string>::const_iterator pos=attribute_names.begin();
     while (pos!=attribute_names.end())
@@ -65,7 +81,16 @@ shape_index_featureset<filterT>::shape_index_featureset(const filterT& filter,
         {
             if (shape_.dbf().descriptor(i).name_ == *pos)
             {
-                attr_ids_.insert(i);
+                std::size_t index = ctx_->push(*pos);
+                if (lazy && index < Feature::max_lazy_slots)
+                {
+                    lazy->add(index, shape_.dbf().descriptor(i));
+                    lazy_slots_ |= boost::uint64_t(1) << index;
+                }
+                else
+                {
+                    attr_ids_.insert(i);
+                }
                 found_name = true;
                 break;
             }
@@ -98,7 +123,7 @@ feature_ptr shape_index_featureset<filterT>::next()
         shape_.move_to(pos);
         int type=shape_.type();
         
-        feature_ptr feature(feature_factory::create(shape_.id_));
+        feature_ptr feature(feature_factory::create(ctx_,shape_.id_));
         if (type == shape_io::shape_point)
         {
             double x=shape_.shp().read_double();
@@ -208,9 +233,13 @@ feature_ptr shape_index_featureset<filterT>::next()
             }
             }
         }
-        if (attr_ids_.size())
+        if (lazy_slots_ || attr_ids_.size())
         {
             shape_.dbf().move_to(shape_.id_);
+            if (lazy_slots_)
+            {
+                feature->set_lazy_attributes(lazy_, shape_.dbf().record(), lazy_slots_);
+            }
             std::set<int>::const_iterator pos=attr_ids_.begin();
             while (pos!=attr_ids_.end())
             {
@@ -40,20 +40,24 @@ class shape_index_featureset : public Featureset
 {
       filterT filter_;
       int shape_type_;      
-      shape_io & shape_;
+      shape_io shape_;
       boost::scoped_ptr<transcoder> tr_;
       std::vector<int> ids_;
       std::vector<int>::iterator itr_;
       std::set<int> attr_ids_;
+      mapnik::lazy_attributes_ptr lazy_;
+      boost::uint64_t lazy_slots_;
+      mapnik::context_ptr ctx_;
       mutable box2d<double> feature_ext_;
       mutable int total_geom_size;
       mutable int count_;
 
    public:
       shape_index_featureset(const filterT& filter,
-                             shape_io& shape,
+                             shape_source const& source,
                              const std::set<std::string>& attribute_names,
-                             std::string const& encoding);
+                             std::string const& encoding,
+                             int generalization_level);
       virtual ~shape_index_featureset();
       feature_ptr next();
    private:
@@ -25,19 +25,76 @@
 #include "shape_io.hpp"
 #include "shape.hpp"
 
+#ifndef _WINDOWS
+#include <sys/mman.h>
+#endif
+
 
 using mapnik::datasource_exception;
 
 const std::string shape_io::SHP = ".shp";
 const std::string shape_io::DBF = ".dbf";
 const std::string shape_io::INDEX = ".index";
+const std::string shape_io::GENERALIZED = ".generalized";
+
+#ifndef _WINDOWS
+// tell the kernel how the mapping is going to be read
+static void advise(mapped_file_source const& mapping, int advice)
+{
+    if (mapping.is_open())
+    {
+        ::madvise(const_cast<char*>(mapping.data()), mapping.size(), advice);
+    }
+}
+#endif
+
+shape_source::shape_source(std::string const& shape_name, bool memory_mapped)
+   : shape_name(shape_name),
+     memory_mapped(memory_mapped)
+{
+    if (!memory_mapped) return;
+    try
+    {
+        shp.open(shape_name + shape_io::SHP);
+        dbf.open(shape_name + shape_io::DBF);
+    }
+    catch (...)
+    {
+        throw datasource_exception("Shape Plugin: cannot read shape file '" + shape_name + "'");
+    }
+    try 
+    {
+        index.open(shape_name + shape_io::INDEX);
+    }
+    catch (...)
+    {
+        std::cerr << "Shape Plugin Warning: Could not open index: '" + shape_name + shape_io::INDEX + "'\n";
+    }
+#ifndef _WINDOWS
+    if (index.is_open())
+    {
+        // indexed queries jump between the records they need, read-ahead
+        // would only pull in pages of unrelated features
+        advise(index, MADV_WILLNEED);
+        advise(shp, MADV_RANDOM);
+        advise(dbf, MADV_RANDOM);
+    }
+    else
+    {
+        // without an index every query scans the whole file
+        advise(shp, MADV_SEQUENTIAL);
+        advise(dbf, MADV_SEQUENTIAL);
+    }
+#endif
+}
 
 shape_io::shape_io(const std::string& shape_name)
    : type_(shape_null),
      shp_(shape_name + SHP),
      dbf_(shape_name + DBF),
      reclength_(0),
-     id_(0)
+     id_(0),
+     level_(-1)
 {
     bool ok = (shp_.is_open() && dbf_.is_open());
     if (!ok)
@@ -54,6 +111,26 @@ shape_io::shape_io(const std::string& shape_name)
     }
 }
 
+shape_io::shape_io(shape_source const& source)
+   : type_(shape_null),
+     shp_(source.shape_name + SHP, source.shp),
+     dbf_(source.shape_name + DBF, source.dbf),
+     reclength_(0),
+     id_(0),
+     generalized_(source.generalized),
+     level_(-1)
+{
+    bool ok = (shp_.is_open() && dbf_.is_open());
+    if (!ok)
+    { 
+        throw datasource_exception("Shape Plugin: cannot read shape file '" + source.shape_name + "'");
+    }
+    if (!source.packed_index)
+    {
+        index_ = boost::shared_ptr<shape_file>(new shape_file(source.shape_name + INDEX, source.index));
+    }
+}
+
 shape_io::~shape_io()
 {
    shp_.close();
@@ -80,6 +157,23 @@ void shape_io::move_to (int pos)
    }
 }
 
+void shape_io::set_generalization_level(int level)
+{
+   level_ = generalized_ ? level : -1;
+}
+
+geometry2d * shape_io::read_generalized()
+{
+   if (level_ < 0) return 0;
+   geometry2d * geom = generalized_->read(level_, id_, type_);
+   if (geom)
+   {
+      // leave the stream at the next record, as reading it would
+      shp_.skip(reclength_*2-36);
+   }
+   return geom;
+}
+
 int shape_io::type() const
 {
    return type_;
@@ -109,6 +203,7 @@ dbf_file& shape_io::dbf()
 geometry2d * shape_io::read_polyline()
 {    
    using mapnik::line_string_impl;
+   if (geometry2d * geom = read_generalized()) return geom;
    shape_file::record_type record(reclength_*2-36);
    shp_.read_record(record);
    int num_parts=record.read_ndr_integer();
@@ -164,6 +259,7 @@ geometry2d * shape_io::read_polyline()
 geometry2d * shape_io::read_polylinem()
 {    
    using mapnik::line_string_impl;
+   if (geometry2d * geom = read_generalized()) return geom;
    shape_file::record_type record(reclength_*2-36);
    shp_.read_record(record);
    int num_parts=record.read_ndr_integer();
@@ -227,6 +323,7 @@ geometry2d * shape_io::read_polylinem()
 geometry2d * shape_io::read_polylinez()
 {
    using mapnik::line_string_impl;
+   if (geometry2d * geom = read_generalized()) return geom;
    shape_file::record_type record(reclength_*2-36);
    shp_.read_record(record);
    int num_parts=record.read_ndr_integer();
@@ -297,6 +394,7 @@ geometry2d * shape_io::read_polylinez()
 geometry2d * shape_io::read_polygon()
 {
    using mapnik::polygon_impl;
+   if (geometry2d * geom = read_generalized()) return geom;
    shape_file::record_type record(reclength_*2-36);
    shp_.read_record(record);
    int num_parts=record.read_ndr_integer();
@@ -338,6 +436,7 @@ geometry2d * shape_io::read_polygon()
 geometry2d * shape_io::read_polygonm()
 {
    using mapnik::polygon_impl;
+   if (geometry2d * geom = read_generalized()) return geom;
    shape_file::record_type record(reclength_*2-36);
    shp_.read_record(record);
    int num_parts=record.read_ndr_integer();
@@ -387,6 +486,7 @@ geometry2d * shape_io::read_polygonm()
 geometry2d * shape_io::read_polygonz()
 {
    using mapnik::polygon_impl;
+   if (geometry2d * geom = read_generalized()) return geom;
    shape_file::record_type record(reclength_*2-36);
    shp_.read_record(record);
    int num_parts=record.read_ndr_integer();
@@ -27,6 +27,8 @@
 #include "dbffile.hpp"
 #include "shapefile.hpp"
 #include "shp_index.hpp"
+#include "shp_packed_index.hpp"
+#include "shp_generalized.hpp"
 // boost
 #include <boost/utility.hpp>
 #include <boost/shared_ptr.hpp>
@@ -37,12 +39,33 @@
 
 using mapnik::geometry2d;
 
+/** The files of one shapefile, opened once by the datasource. Every
+ *  shape_io created from a shape_source has its own read positions, so
+ *  concurrent queries never share a cursor. When memory mapped the .shp,
+ *  .dbf and .index mappings themselves are shared; otherwise each reader
+ *  opens its own file streams. With a packed_index readers don't open
+ *  the .index at all. With generalized, readers can be asked to return
+ *  simplified line and polygon geometries.
+ */
+struct shape_source : boost::noncopyable
+{
+    shape_source(std::string const& shape_name, bool memory_mapped);
+    std::string shape_name;
+    bool memory_mapped;
+    mapped_file_source shp;
+    mapped_file_source dbf;
+    mapped_file_source index;
+    boost::shared_ptr<shp_packed_index> packed_index;
+    boost::shared_ptr<shp_generalized> generalized;
+};
+
 struct shape_io : boost::noncopyable
 {
     static const std::string SHP;
     static const std::string SHX;
     static const std::string DBF;
     static const std::string INDEX;
+    static const std::string GENERALIZED;
     unsigned type_;
     shape_file shp_;
     shape_file shx_;
@@ -51,6 +74,8 @@ struct shape_io : boost::noncopyable
     unsigned reclength_;
     unsigned id_;
     box2d<double> cur_extent_;
+    boost::shared_ptr<shp_generalized> generalized_;
+    int level_;
     
 public:
     enum shapeType
@@ -72,6 +97,7 @@ public:
     };
 
     shape_io(const std::string& shape_name);
+    explicit shape_io(shape_source const& source);
     ~shape_io();
     shape_file& shp();
     shape_file& shx();
@@ -87,6 +113,9 @@ public:
         return (index_ && index_->is_open());
     }
     void move_to(int id);
+    // the read_* functions return the geometries of this level of the
+    // source's generalized file where available, -1 for the originals
+    void set_generalization_level(int level);
     int type() const;
     const box2d<double>& current_extent() const;
     geometry2d * read_polyline();
@@ -95,6 +124,8 @@ public:
     geometry2d * read_polygon();
     geometry2d * read_polygonm();
     geometry2d * read_polygonz();
+private:
+    geometry2d * read_generalized();
 };
 
 #endif //SHAPE_IO_HPP
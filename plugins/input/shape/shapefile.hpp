@@ -36,6 +36,7 @@
 #include <boost/iostreams/device/mapped_file.hpp>
 
 #include <cstring>
+#include <vector>
 
 using mapnik::box2d;
 using mapnik::read_int32_ndr;
@@ -44,20 +45,6 @@ using mapnik::read_double_ndr;
 using mapnik::read_double_xdr;
 
 
-struct RecordTag
-{
-    typedef char* data_type;
-    static data_type alloc(unsigned size)
-    {
-        return static_cast<data_type>(::operator new(sizeof(char)*size));
-    }
-    
-    static void dealloc(data_type data)
-    {
-        ::operator delete(data);
-    }
-};
-
 struct MappedRecordTag
 {
     typedef const char* data_type;
@@ -129,62 +116,95 @@ struct shape_record
 
 using namespace boost::iostreams;
 
+/** Sequential reader over a .shp, .shx or .index file.
+ *
+ *  A memory mapped shape_file parses straight out of the mapping, records
+ *  point into it and nothing is copied or allocated per record. Otherwise
+ *  the file is read through a stream and records are read into a buffer
+ *  reused for the lifetime of the shape_file.
+ */
 class shape_file : boost::noncopyable
 {  
 public:
-
-#ifdef SHAPE_MEMORY_MAPPED_FILE
-    typedef stream<mapped_file_source> file_source_type;
-    typedef shape_record<MappedRecordTag> record_type;
-#else
     typedef stream<file_source> file_source_type;
-    typedef shape_record<RecordTag> record_type;
-#endif
-    
-    file_source_type file_;    
-    shape_file() {}
+    typedef shape_record<MappedRecordTag> record_type;
+
+    shape_file()
+        : data_(0), size_(0), pos_(0), eof_(false) {}
     
-    shape_file(std::string  const& file_name)
-        : 
+    shape_file(std::string const& file_name)
+        : data_(0), size_(0), pos_(0), eof_(false)
+    {
 #ifdef SHAPE_MEMORY_MAPPED_FILE
-        file_(file_name)
+        open(file_name, true);
 #else
-        file_(file_name,std::ios::in | std::ios::binary)
+        open(file_name, false);
 #endif
-    {}
-    
-    ~shape_file() {}
+    }
+
+    shape_file(std::string const& file_name, bool memory_mapped)
+        : data_(0), size_(0), pos_(0), eof_(false)
+    {
+        open(file_name, memory_mapped);
+    }
 
-    inline file_source_type & file()
+    // own read position over a mapping shared with other shape_files,
+    // or over a stream of its own if the file isn't mapped
+    shape_file(std::string const& file_name, mapped_file_source const& mapping)
+        : mapping_(mapping), data_(0), size_(0), pos_(0), eof_(false)
     {
-        return file_;
+        if (mapping_.is_open())
+        {
+            data_ = mapping_.data();
+            size_ = mapping_.size();
+        }
+        else
+        {
+            open(file_name, false);
+        }
     }
     
+    ~shape_file() {}
+
     inline bool is_open()
     {
-        return file_.is_open();
+        return data_ != 0 || file_.is_open();
     }
- 
+
+    inline bool is_memory_mapped() const
+    {
+        return data_ != 0;
+    }
+
+    // releases this reader; a mapping shared with other readers stays
+    // mapped until the last of them goes away
     inline void close()
     {
+        data_ = 0;
+        size_ = 0;
+        mapping_ = mapped_file_source();
         if (file_ && file_.is_open())
             file_.close();
     }
     
     inline void read_record(record_type& rec)
     {
-#ifdef SHAPE_MEMORY_MAPPED_FILE
-        rec.set_data(file_->data() + file_.tellg());
-        file_.seekg(rec.size,std::ios::cur);
-#else
-        file_.read(rec.get_data(),rec.size);
-#endif
+        if (data_ && pos_ + rec.size <= size_)
+        {
+            rec.set_data(data_ + pos_);
+            pos_ += rec.size;
+            return;
+        }
+        // truncated record or no mapping: go through the buffer
+        if (buffer_.size() < rec.size) buffer_.resize(rec.size);
+        read(&buffer_[0], rec.size);
+        rec.set_data(&buffer_[0]);
     }
     
     inline int read_xdr_integer()
     {
         char b[4];
-        file_.read(b, 4);
+        read(b,4);
         boost::int32_t val;
         read_int32_xdr(b,val);
         return val;
@@ -193,7 +213,7 @@ public:
     inline int read_ndr_integer()
     {
         char b[4];
-        file_.read(b,4);
+        read(b,4);
         boost::int32_t val;
         read_int32_ndr(b,val);
         return val;
@@ -203,10 +223,10 @@ public:
     {
         double val;
 #ifndef MAPNIK_BIG_ENDIAN
-        file_.read(reinterpret_cast<char*>(&val),8);
+        read(reinterpret_cast<char*>(&val),8);
 #else
         char b[8];
-        file_.read(b,8);
+        read(b,8);
         read_double_ndr(b,val);
 #endif
         return val;
@@ -215,10 +235,10 @@ public:
     inline void read_envelope(box2d<double>& envelope)
     {
 #ifndef MAPNIK_BIG_ENDIAN
-        file_.read(reinterpret_cast<char*>(&envelope),sizeof(envelope));
+        read(reinterpret_cast<char*>(&envelope),sizeof(envelope));
 #else
         char data[4*8];
-        file_.read(data,4*8);
+        read(data,4*8);
         double minx,miny,maxx,maxy;
         read_double_ndr(data + 0*8,minx);
         read_double_ndr(data + 1*8,miny);
@@ -230,7 +250,8 @@ public:
       
     inline void skip(std::streampos bytes)
     {
-        file_.seekg(bytes,std::ios::cur);
+        if (data_) pos_ += static_cast<std::streamoff>(bytes);
+        else file_.seekg(bytes,std::ios::cur);
     }
       
     inline void rewind()
@@ -240,18 +261,78 @@ public:
       
     inline void seek(std::streampos pos)
     {
-        file_.seekg(pos,std::ios::beg);
+        if (data_)
+        {
+            pos_ = static_cast<std::streamoff>(pos);
+            eof_ = false;
+        }
+        else file_.seekg(pos,std::ios::beg);
     }
       
     inline std::streampos pos()
     {
+        if (data_) return std::streampos(pos_);
         return file_.tellg();
     }
       
     inline bool is_eof()
     {
+        if (data_) return eof_;
         return file_.eof();
     }
+
+private:
+    void open(std::string const& file_name, bool memory_mapped)
+    {
+        if (memory_mapped)
+        {
+            try
+            {
+                mapping_.open(file_name);
+                data_ = mapping_.data();
+                size_ = mapping_.size();
+            }
+            catch (...) {}
+        }
+        else
+        {
+            file_.open(file_name,std::ios::in | std::ios::binary);
+            // the stream reports open even if the file couldn't be
+            if (file_.is_open() && !file_->is_open()) file_.close();
+        }
+    }
+
+    // reading past the end behaves like the stream: eof is set and the
+    // missing bytes are zero
+    inline void read(char* buf, std::size_t n)
+    {
+        if (data_)
+        {
+            std::size_t avail = pos_ < size_ ? size_ - pos_ : 0;
+            if (n > avail)
+            {
+                if (avail) std::memcpy(buf, data_ + pos_, avail);
+                std::memset(buf + avail, 0, n - avail);
+                pos_ = size_;
+                eof_ = true;
+                return;
+            }
+            std::memcpy(buf, data_ + pos_, n);
+            pos_ += n;
+        }
+        else
+        {
+            file_.read(buf, n);
+        }
+    }
+
+    mapped_file_source mapping_;
+    const char* data_;
+    std::size_t size_;
+    std::size_t pos_;
+    bool eof_;
+    file_source_type file_;
+    std::vector<char> buffer_;
 };
 
 #endif //SHAPEFILE_HPP
@@ -0,0 +1,365 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2006 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/datasource.hpp>
+#include <mapnik/vertex_filter.hpp>
+// boost
+#include <boost/format.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/filesystem/operations.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#endif
+// stl
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+// getpid
+#ifdef _WINDOWS
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "shp_generalized.hpp"
+#include "shape_io.hpp"
+
+using mapnik::coord2d;
+using mapnik::datasource_exception;
+
+namespace {
+
+const char magic[] = "mapnik-gen";
+const std::size_t header_size = 40;
+const std::size_t level_size = 16;
+
+#ifdef MAPNIK_THREADSAFE
+boost::mutex temp_mutex;
+#endif
+unsigned temp_count = 0;
+
+// a name no other build writes to, in this or another process
+std::string temp_name(std::string const& file_name)
+{
+    unsigned count;
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(temp_mutex);
+#endif
+        count = ++temp_count;
+    }
+    return (boost::format("%s.%d.%d.tmp") % file_name % getpid() % count).str();
+}
+
+bool is_polygon(int shape_type)
+{
+    return shape_type == shape_io::shape_polygon ||
+        shape_type == shape_io::shape_polygonm ||
+        shape_type == shape_io::shape_polygonz;
+}
+
+bool is_polyline(int shape_type)
+{
+    return shape_type == shape_io::shape_polyline ||
+        shape_type == shape_io::shape_polylinem ||
+        shape_type == shape_io::shape_polylinez;
+}
+
+geometry2d * read_original(shape_io & shape)
+{
+    switch (shape.type())
+    {
+    case shape_io::shape_polyline:
+        return shape.read_polyline();
+    case shape_io::shape_polylinem:
+        return shape.read_polylinem();
+    case shape_io::shape_polylinez:
+        return shape.read_polylinez();
+    case shape_io::shape_polygon:
+        return shape.read_polygon();
+    case shape_io::shape_polygonm:
+        return shape.read_polygonm();
+    case shape_io::shape_polygonz:
+        return shape.read_polygonz();
+    }
+    return 0;
+}
+
+template <typename T>
+void write_value(std::ostream & out, T const& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T read_value(const char* data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+// simplifies geom and writes it as a record, false if no point was dropped
+bool write_record(std::ostream & out, geometry2d const& geom, bool polygon, double tolerance)
+{
+    std::vector<coord2d> points;
+    std::vector<std::size_t> parts;
+    points.reserve(geom.num_points());
+    for (unsigned i = 0; i < geom.num_points(); ++i)
+    {
+        double x, y;
+        if (geom.get_vertex(i, &x, &y) == mapnik::SEG_MOVETO || parts.empty())
+        {
+            parts.push_back(points.size());
+        }
+        points.push_back(coord2d(x, y));
+    }
+    if (points.empty()) return false;
+    parts.push_back(points.size());
+
+    std::vector<char> keep(points.size(), 0);
+    std::vector<int> out_parts;
+    std::vector<coord2d> out_points;
+    // rings need four points, lines two, smaller parts are below a pixel
+    std::size_t min_points = polygon ? 4 : 2;
+    for (std::size_t k = 0; k + 1 < parts.size(); ++k)
+    {
+        std::size_t first = parts[k];
+        std::size_t last = parts[k + 1] - 1;
+        mapnik::douglas_peucker(points, first, last, tolerance * tolerance, keep);
+        std::size_t count = std::count(keep.begin() + first, keep.begin() + last + 1, 1);
+        if (count < min_points) continue;
+        out_parts.push_back(out_points.size());
+        for (std::size_t i = first; i <= last; ++i)
+        {
+            if (keep[i]) out_points.push_back(points[i]);
+        }
+    }
+    if (out_parts.empty())
+    {
+        // keep what is left of the first part so that the feature does not vanish
+        out_parts.push_back(0);
+        for (std::size_t i = parts[0]; i < parts[1]; ++i)
+        {
+            if (keep[i]) out_points.push_back(points[i]);
+        }
+    }
+    // the original record is as good and spares the space
+    if (out_points.size() == points.size()) return false;
+
+    write_value<boost::int32_t>(out, out_parts.size());
+    write_value<boost::int32_t>(out, out_points.size());
+    for (std::size_t k = 0; k < out_parts.size(); ++k)
+    {
+        write_value<boost::int32_t>(out, out_parts[k]);
+    }
+    for (std::size_t i = 0; i < out_points.size(); ++i)
+    {
+        write_value(out, out_points[i].x);
+        write_value(out, out_points[i].y);
+    }
+    return true;
+}
+
+}
+
+const int shp_generalized::version;
+
+shp_generalized::shp_generalized(std::string const& file_name, boost::uint64_t shp_size)
+    : num_records_(0)
+{
+    try
+    {
+        file_.open(file_name);
+    }
+    catch (...)
+    {
+        throw datasource_exception("Shape Plugin: cannot read generalized file '" + file_name + "'");
+    }
+    const char* data = file_.data();
+    std::size_t size = file_.size();
+    if (size < header_size || std::memcmp(data, magic, sizeof(magic)) != 0 ||
+        read_value<boost::int32_t>(data + 16) != version ||
+        read_value<boost::uint64_t>(data + 32) != shp_size)
+    {
+        throw datasource_exception("Shape Plugin: '" + file_name + "' does not match the shape file");
+    }
+    boost::int32_t levels = read_value<boost::int32_t>(data + 20);
+    num_records_ = read_value<boost::uint32_t>(data + 24);
+    if (levels < 0 || header_size + levels * level_size > size)
+    {
+        throw datasource_exception("Shape Plugin: '" + file_name + "' is truncated");
+    }
+    for (boost::int32_t level = 0; level < levels; ++level)
+    {
+        const char* entry = data + header_size + level * level_size;
+        boost::uint64_t table = read_value<boost::uint64_t>(entry + 8);
+        if (table < header_size || table > size || boost::uint64_t(num_records_) * 8 > size - table)
+        {
+            throw datasource_exception("Shape Plugin: '" + file_name + "' is truncated");
+        }
+        tolerances_.push_back(read_value<double>(entry));
+        tables_.push_back(table);
+    }
+}
+
+void shp_generalized::build(shape_source const& source,
+                            std::string const& file_name,
+                            box2d<double> const& extent,
+                            unsigned levels)
+{
+    shape_io shape(source);
+    shape.shp().seek(24);
+    boost::uint64_t shp_end = 2 * boost::uint64_t(shape.shp().read_xdr_integer());
+
+    // readers must never map a partially written file
+    std::string tmp_name = temp_name(file_name);
+    try
+    {
+        std::ofstream out(tmp_name.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!out)
+        {
+            throw datasource_exception("Shape Plugin: cannot write '" + tmp_name + "'");
+        }
+        out.exceptions(std::ios::failbit | std::ios::badbit);
+        std::vector<char> header(header_size + levels * level_size, 0);
+        out.write(&header[0], header.size());
+
+        std::vector<double> tolerances;
+        std::vector<boost::uint64_t> tables;
+        std::vector<boost::uint64_t> table;
+        boost::uint32_t num_records = 0;
+        double size = std::max(extent.width(), extent.height());
+        for (unsigned level = 0; level < levels; ++level)
+        {
+            // half a pixel with the extent 256 << level pixels wide
+            double tolerance = std::ldexp(size / 512.0, -int(level));
+            table.assign(num_records, 0);
+            boost::uint64_t pos = 100;
+            while (pos < shp_end)
+            {
+                shape.move_to(pos);
+                if (shape.shp().is_eof()) break;
+                pos += 8 + 2 * boost::uint64_t(shape.reclength_);
+                if (shape.id_ >= num_records) num_records = shape.id_ + 1;
+                boost::scoped_ptr<geometry2d> geom(read_original(shape));
+                if (!geom) continue;
+                boost::uint64_t record = out.tellp();
+                if (write_record(out, *geom, is_polygon(shape.type()), tolerance))
+                {
+                    if (shape.id_ >= table.size()) table.resize(shape.id_ + 1, 0);
+                    table[shape.id_] = record;
+                }
+            }
+            table.resize(num_records, 0);
+            tolerances.push_back(tolerance);
+            tables.push_back(out.tellp());
+            if (!table.empty())
+            {
+                out.write(reinterpret_cast<const char*>(&table[0]), table.size() * sizeof(boost::uint64_t));
+            }
+        }
+
+        out.seekp(0);
+        out.write(magic, sizeof(magic));
+        out.seekp(16);
+        write_value<boost::int32_t>(out, version);
+        write_value<boost::int32_t>(out, levels);
+        write_value<boost::uint32_t>(out, num_records);
+        write_value<boost::uint32_t>(out, 0);
+        write_value<boost::uint64_t>(out, boost::filesystem::file_size(source.shape_name + shape_io::SHP));
+        for (unsigned level = 0; level < levels; ++level)
+        {
+            write_value(out, tolerances[level]);
+            write_value(out, tables[level]);
+        }
+    }
+    catch (...)
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove(tmp_name, ec);
+        throw;
+    }
+    // replaces an outdated file_name in one step
+    boost::filesystem::rename(tmp_name, file_name);
+}
+
+int shp_generalized::level(double resolution) const
+{
+    if (resolution <= 0.0) return -1;
+    double half_pixel = 0.5 / resolution;
+    for (std::size_t level = 0; level < tolerances_.size(); ++level)
+    {
+        if (tolerances_[level] <= half_pixel) return level;
+    }
+    return -1;
+}
+
+geometry2d * shp_generalized::read(int level, unsigned id, int shape_type) const
+{
+    using mapnik::line_string_impl;
+    using mapnik::polygon_impl;
+    if (level < 0 || level >= int(tables_.size()) || id >= num_records_) return 0;
+    if (!is_polygon(shape_type) && !is_polyline(shape_type)) return 0;
+    const char* data = file_.data();
+    boost::uint64_t size = file_.size();
+    boost::uint64_t pos = read_value<boost::uint64_t>(data + tables_[level] + id * 8);
+    // a damaged file falls back to the .shp record rather than reading past the end
+    if (!pos || pos < header_size || pos + 8 > size) return 0;
+
+    const char* record = data + pos;
+    boost::int32_t num_parts = read_value<boost::int32_t>(record);
+    boost::int32_t num_points = read_value<boost::int32_t>(record + 4);
+    if (num_parts < 1 || num_points < 0 ||
+        pos + 8 + 4 * boost::uint64_t(num_parts) + 16 * boost::uint64_t(num_points) > size)
+    {
+        return 0;
+    }
+    const char* parts = record + 8;
+    const char* coords = parts + 4 * num_parts;
+    for (boost::int32_t k = 0; k < num_parts; ++k)
+    {
+        boost::int32_t start = read_value<boost::int32_t>(parts + 4 * k);
+        boost::int32_t end = (k + 1 < num_parts) ? read_value<boost::int32_t>(parts + 4 * (k + 1)) : num_points;
+        if (start < 0 || start > end || end > num_points) return 0;
+    }
+    geometry2d * geom;
+    if (is_polygon(shape_type)) geom = new polygon_impl;
+    else geom = new line_string_impl;
+    geom->set_capacity(num_points + num_parts);
+    for (boost::int32_t k = 0; k < num_parts; ++k)
+    {
+        boost::int32_t start = read_value<boost::int32_t>(parts + 4 * k);
+        boost::int32_t end = (k + 1 < num_parts) ? read_value<boost::int32_t>(parts + 4 * (k + 1)) : num_points;
+        for (boost::int32_t i = start; i < end; ++i)
+        {
+            double x = read_value<double>(coords + 16 * i);
+            double y = read_value<double>(coords + 16 * i + 8);
+            if (i == start) geom->move_to(x, y);
+            else geom->line_to(x, y);
+        }
+    }
+    return geom;
+}
@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2006 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef SHP_GENERALIZED_HPP
+#define SHP_GENERALIZED_HPP
+
+// mapnik
+#include <mapnik/box2d.hpp>
+#include <mapnik/geometry.hpp>
+// boost
+#include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+// stl
+#include <string>
+#include <vector>
+
+using mapnik::box2d;
+using mapnik::geometry2d;
+using boost::iostreams::mapped_file_source;
+
+struct shape_source;
+
+/** Douglas-Peucker simplified copies of the line and polygon records of
+ *  a shapefile, kept in a <name>.generalized file next to the .index.
+ *
+ *  Level 0 is the coarsest and is exact to half a pixel when the whole
+ *  extent is rendered 256 pixels wide, every following level doubles that
+ *  width. Queries at a low resolution read the simplified geometry of a
+ *  level instead of the .shp record, which for world scale renders saves
+ *  most of the I/O and nearly all vertices.
+ *
+ *  File layout, native byte order: a 16 byte "mapnik-gen" header, the
+ *  version, the number of levels and of records, the size of the .shp,
+ *  then per level its tolerance and the position of its table, which
+ *  holds the position of every generalized record by record number (0
+ *  for none). A record is its number of parts and points, the first
+ *  point of every part and the coordinates.
+ */
+class shp_generalized : boost::noncopyable
+{
+public:
+    static const int version = 1;
+
+    // maps file_name, throws if it is not a generalization of shp_size bytes of .shp
+    shp_generalized(std::string const& file_name, boost::uint64_t shp_size);
+
+    // simplifies the records of source into levels levels written to file_name
+    static void build(shape_source const& source,
+                      std::string const& file_name,
+                      box2d<double> const& extent,
+                      unsigned levels);
+
+    /** Returns the coarsest level exact to half a pixel at resolution
+      * (pixels per shapefile unit, as query::resolution() carries it),
+      * -1 if the original geometries are needed.
+      */
+    int level(double resolution) const;
+
+    unsigned num_levels() const
+    {
+        return tolerances_.size();
+    }
+
+    double tolerance(unsigned level) const
+    {
+        return tolerances_[level];
+    }
+
+    /** Returns the geometry of record id at level, 0 if the record has
+      * no generalized geometry. shape_type is the type of the record.
+      */
+    geometry2d * read(int level, unsigned id, int shape_type) const;
+
+private:
+    mapped_file_source file_;
+    boost::uint32_t num_records_;
+    std::vector<double> tolerances_;
+    std::vector<boost::uint64_t> tables_;
+};
+
+#endif //SHP_GENERALIZED_HPP
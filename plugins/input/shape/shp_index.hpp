@@ -23,17 +23,18 @@
 #ifndef SHP_INDEX_HH
 #define SHP_INDEX_HH
 
-// st
-#include <fstream>
+// stl
 #include <vector>
 // mapnik
 #include <mapnik/box2d.hpp>
 #include <mapnik/query.hpp>
 
+#include "shapefile.hpp"
+
 using mapnik::box2d;
 using mapnik::query;
 
-template <typename filterT, typename IStream = std::ifstream>
+template <typename filterT, typename IStream = shape_file>
 class shp_index
 {
 public:
@@ -43,41 +44,39 @@ private:
     ~shp_index();
     shp_index(const shp_index&);
     shp_index& operator=(const shp_index&);
-    static int read_ndr_integer(IStream & in);
-    static void read_envelope(IStream & in,box2d<double> &envelope);
     static void query_node(const filterT& filter,IStream & in,std::vector<int>& pos);
 };
 
 template <typename filterT,typename IStream>
 void shp_index<filterT, IStream>::query(const filterT& filter,IStream & file,std::vector<int>& pos)
 {
-    file.seekg(16,std::ios::beg);
+    file.seek(16);
     query_node(filter,file,pos);
 }
 
 template <typename filterT, typename IStream>
 void shp_index<filterT,IStream>::query_node(const filterT& filter,IStream &  file,std::vector<int>& ids)
 {
-    int offset=read_ndr_integer(file);
+    int offset=file.read_ndr_integer();
 
     box2d<double> node_ext;
-    read_envelope(file,node_ext);
+    file.read_envelope(node_ext);
 
-    int num_shapes=read_ndr_integer(file);
+    int num_shapes=file.read_ndr_integer();
 
     if (!filter.pass(node_ext))
     {
-        file.seekg(offset+num_shapes*4+4,std::ios::cur);
+        file.skip(offset+num_shapes*4+4);
         return;
     }
     
     for (int i=0;i<num_shapes;++i)
     {
-        int id=read_ndr_integer(file);
+        int id=file.read_ndr_integer();
         ids.push_back(id);
     }
 
-    int children=read_ndr_integer(file);
+    int children=file.read_ndr_integer();
 
     for (int j=0;j<children;++j)
     {
@@ -85,21 +84,4 @@ void shp_index<filterT,IStream>::query_node(const filterT& filter,IStream &  fil
     }
 }
 
-
-template <typename filterT,typename IStream>
-int shp_index<filterT,IStream>::read_ndr_integer(IStream & file)
-{
-    char b[4];
-    file.read(b,4);
-    return (b[0]&0xff) | (b[1]&0xff)<<8 | (b[2]&0xff)<<16 | (b[3]&0xff)<<24;
-}
-
-
-template <typename filterT,typename IStream>
-void shp_index<filterT,IStream>::read_envelope(IStream & file,box2d<double>& envelope)
-{
-    file.read(reinterpret_cast<char*>(&envelope),sizeof(envelope));
-}
-
-
 #endif //SHP_INDEX_HH
@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2006 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "shp_packed_index.hpp"
+
+shp_packed_index::shp_packed_index(shape_file & file)
+{
+    file.seek(16);
+    read_node(file);
+    // trim the excess capacity, the index lives as long as the datasource
+    std::vector<node>(nodes_).swap(nodes_);
+    std::vector<int>(ids_).swap(ids_);
+}
+
+void shp_packed_index::read_node(shape_file & file)
+{
+    std::size_t index = nodes_.size();
+    nodes_.push_back(node());
+
+    file.read_ndr_integer(); // offset to the children, not needed here
+    box2d<double> ext;
+    file.read_envelope(ext);
+    int num_shapes = file.read_ndr_integer();
+    if (file.is_eof()) 
+    {
+        // truncated index, drop the partial node
+        nodes_.pop_back();
+        return;
+    }
+    nodes_[index].ext = ext;
+    nodes_[index].first = ids_.size();
+    for (int i = 0; i < num_shapes; ++i)
+    {
+        ids_.push_back(file.read_ndr_integer());
+    }
+    nodes_[index].count = num_shapes;
+
+    int children = file.read_ndr_integer();
+    for (int j = 0; j < children && !file.is_eof(); ++j)
+    {
+        read_node(file);
+    }
+    nodes_[index].next = nodes_.size();
+}
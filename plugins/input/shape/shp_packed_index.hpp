@@ -0,0 +1,92 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2006 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef SHP_PACKED_INDEX_HPP
+#define SHP_PACKED_INDEX_HPP
+
+// mapnik
+#include <mapnik/box2d.hpp>
+// boost
+#include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
+// stl
+#include <vector>
+
+#include "shapefile.hpp"
+
+using mapnik::box2d;
+
+/** A shapefile .index loaded once into flat arrays.
+ *
+ *  The quadtree nodes are stored in depth first order, each with the
+ *  position of the first node after its subtree, and the shape offsets of
+ *  all nodes in one contiguous array. A query is a single forward pass
+ *  over the node array that jumps past subtrees failing the filter,
+ *  without pointers, recursion or file reads.
+ */
+class shp_packed_index : boost::noncopyable
+{
+public:
+    // reads the whole index, file has to be positioned anywhere
+    explicit shp_packed_index(shape_file & file);
+
+    template <typename filterT>
+    void query(filterT const& filter, std::vector<int>& ids) const
+    {
+        std::size_t i = 0;
+        std::size_t size = nodes_.size();
+        while (i < size)
+        {
+            node const& n = nodes_[i];
+            if (filter.pass(n.ext))
+            {
+                ids.insert(ids.end(), ids_.begin() + n.first, ids_.begin() + n.first + n.count);
+                ++i;
+            }
+            else
+            {
+                i = n.next;
+            }
+        }
+    }
+
+    std::size_t num_nodes() const
+    {
+        return nodes_.size();
+    }
+
+private:
+    struct node
+    {
+        box2d<double> ext;
+        boost::uint32_t first;
+        boost::uint32_t count;
+        boost::uint32_t next;
+    };
+
+    void read_node(shape_file & file);
+
+    std::vector<node> nodes_;
+    std::vector<int> ids_;
+};
+
+#endif //SHP_PACKED_INDEX_HPP
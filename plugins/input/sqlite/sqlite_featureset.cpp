@@ -85,20 +85,20 @@ feature_ptr sqlite_featureset::next()
            {
               case SQLITE_INTEGER:
               {
-                 boost::put(*feature,fld_name,rs_->column_integer (i));
+                 feature->put(fld_name,rs_->column_integer (i));
                  break;
               }
               
               case SQLITE_FLOAT:
               {
-                 boost::put(*feature,fld_name,rs_->column_double (i));
+                 feature->put(fld_name,rs_->column_double (i));
                  break;
               }
               
               case SQLITE_TEXT:
               {
                  UnicodeString ustr = tr_->transcode (rs_->column_text (i));
-                 boost::put(*feature,fld_name,ustr);
+                 feature->put(fld_name,ustr);
                  break;
               }
               
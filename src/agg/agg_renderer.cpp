@@ -107,18 +107,50 @@ private:
 };
 
 
+agg_render_context::agg_render_context()
+    : font_engine_(),
+      font_manager_(font_engine_),
+      ras_ptr_(new rasterizer) {}
+
+agg_render_context::~agg_render_context() {}
+
 template <typename T>
 agg_renderer<T>::agg_renderer(Map const& m, T & pixmap, double scale_factor, unsigned offset_x, unsigned offset_y)
     : feature_style_processor<agg_renderer>(m, scale_factor),
+      own_context_(new agg_render_context),
       pixmap_(pixmap),
       width_(pixmap_.width()),
       height_(pixmap_.height()),
       scale_factor_(scale_factor),
       t_(m.width(),m.height(),m.get_current_extent(),offset_x,offset_y),
-      font_engine_(),
-      font_manager_(font_engine_),
-      detector_(box2d<double>(-m.buffer_size(), -m.buffer_size(), m.width() + m.buffer_size() ,m.height() + m.buffer_size())),
-      ras_ptr(new rasterizer)
+      font_manager_(own_context_->font_manager()),
+      detector_(box2d<double>(-m.buffer_size(), -m.buffer_size(), m.width() + m.buffer_size() ,m.height() + m.buffer_size()), m.label_detector()),
+      scratch_detector_(detector_.extent(), GRID_DETECTOR),
+      ras_ptr(&own_context_->get_rasterizer())
+{
+    setup(m);
+}
+
+template <typename T>
+agg_renderer<T>::agg_renderer(Map const& m, T & pixmap, agg_render_context & ctx, double scale_factor, unsigned offset_x, unsigned offset_y)
+    : feature_style_processor<agg_renderer>(m, scale_factor),
+      pixmap_(pixmap),
+      width_(pixmap_.width()),
+      height_(pixmap_.height()),
+      scale_factor_(scale_factor),
+      t_(m.width(),m.height(),m.get_current_extent(),offset_x,offset_y),
+      font_manager_(ctx.font_manager()),
+      detector_(box2d<double>(-m.buffer_size(), -m.buffer_size(), m.width() + m.buffer_size() ,m.height() + m.buffer_size()), m.label_detector()),
+      scratch_detector_(detector_.extent(), GRID_DETECTOR),
+      ras_ptr(&ctx.get_rasterizer())
+{
+    // the symbolizers reset the rasterizer and set its gamma before use
+    ras_ptr->reset();
+    setup(m);
+}
+
+template <typename T>
+void agg_renderer<T>::setup(Map const& m)
 {
     boost::optional<color> const& bg = m.background();
     if (bg) pixmap_.set_background(*bg);
@@ -170,6 +202,7 @@ void agg_renderer<T>::end_map_processing(Map const& )
 #ifdef MAPNIK_DEBUG
     std::clog << "end map processing\n";
 #endif
+    render_deferred_labels();
 }
 
 template <typename T>
@@ -191,6 +224,7 @@ void agg_renderer<T>::end_layer_processing(layer const&)
 #ifdef MAPNIK_DEBUG
     std::clog << "end layer processing\n";
 #endif
+    render_deferred_labels();
 }
 
 template class agg_renderer<image_32>;
@@ -86,12 +86,12 @@ void agg_renderer<T>::process(building_symbolizer const& sym,
             std::deque<segment_t> face_segments;
             double x0(0);
             double y0(0);
-            unsigned cm = geom.vertex(&x0,&y0);
+            unsigned cm = geom.get_vertex(0,&x0,&y0);
             for (unsigned j=1;j<geom.num_points();++j)
             {
                 double x(0);
                 double y(0);
-                cm = geom.vertex(&x,&y);
+                cm = geom.get_vertex(j,&x,&y);
                 if (cm == SEG_MOVETO)
                 {
                     frame->move_to(x,y);
@@ -125,11 +125,10 @@ void agg_renderer<T>::process(building_symbolizer const& sym,
                 frame->line_to(itr->get<0>(),itr->get<1>()+height);
             }
 
-            geom.rewind(0);
             for (unsigned j=0;j<geom.num_points();++j)
             {
                 double x,y;
-                unsigned cm = geom.vertex(&x,&y);
+                unsigned cm = geom.get_vertex(j,&x,&y);
                 if (cm == SEG_MOVETO)
                 {
                     frame->move_to(x,y+height);
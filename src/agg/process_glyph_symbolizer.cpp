@@ -48,7 +48,7 @@ void agg_renderer<T>::process(glyph_symbolizer const& sym,
         prj_trans.backward(x,y,z);
         t_.forward(&x, &y);
 
-        text_renderer<T> ren(pixmap_, faces, *strk);
+        text_renderer<T> ren(pixmap_, faces, *strk, font_manager_.get_glyph_cache());
 
         // set fill and halo colors
         color fill = sym.eval_color(feature);
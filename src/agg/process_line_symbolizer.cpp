@@ -24,6 +24,7 @@
 // mapnik
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/agg_rasterizer.hpp>
+#include <mapnik/vertex_filter.hpp>
 
 // agg
 #include "agg_basics.h"
@@ -51,6 +52,7 @@ void agg_renderer<T>::process(line_symbolizer const& sym,
 {
     typedef agg::renderer_base<agg::pixfmt_rgba32_plain> ren_base;
     typedef coord_transform2<CoordTransform,geometry2d> path_type;
+    typedef vertex_filter<path_type> filter_type;
     typedef agg::renderer_outline_aa<ren_base> renderer_oaa;
     typedef agg::rasterizer_outline_aa<renderer_oaa> rasterizer_outline_aa;
     typedef agg::renderer_scanline_aa_solid<ren_base> renderer;
@@ -77,10 +79,13 @@ void agg_renderer<T>::process(line_symbolizer const& sym,
         if (geom.num_points() > 1)
         {
             path_type path(t_,geom,prj_trans);
+            filter_type filtered(path,
+                                 sym.get_simplify_tolerance() * scale_factor_,
+                                 sym.get_simplify_algorithm());
 
             if (stroke_.has_dash())
             {
-                agg::conv_dash<path_type> dash(path);
+                agg::conv_dash<filter_type> dash(filtered);
                 dash_array const& d = stroke_.get_dash_array();
                 dash_array::const_iterator itr = d.begin();
                 dash_array::const_iterator end = d.end();
@@ -90,7 +95,7 @@ void agg_renderer<T>::process(line_symbolizer const& sym,
                                   itr->second * scale_factor_);
                 }
 
-                agg::conv_stroke<agg::conv_dash<path_type > > stroke(dash);
+                agg::conv_stroke<agg::conv_dash<filter_type> > stroke(dash);
 
                 line_join_e join=stroke_.get_line_join();
                 if ( join == MITER_JOIN)
@@ -118,7 +123,7 @@ void agg_renderer<T>::process(line_symbolizer const& sym,
             }
             else
             {
-                agg::conv_stroke<path_type>  stroke(path);
+                agg::conv_stroke<filter_type>  stroke(filtered);
                 line_join_e join=stroke_.get_line_join();
                 if ( join == MITER_JOIN)
                     stroke.generator().line_join(agg::miter_join);
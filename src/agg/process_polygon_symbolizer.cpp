@@ -24,6 +24,7 @@
 // mapnik
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/agg_rasterizer.hpp>
+#include <mapnik/vertex_filter.hpp>
 
 // agg
 #include "agg_basics.h"
@@ -45,6 +46,7 @@ void agg_renderer<T>::process(polygon_symbolizer const& sym,
                               proj_transform const& prj_trans)
 {
     typedef coord_transform2<CoordTransform,geometry2d> path_type;
+    typedef vertex_filter<path_type> filter_type;
     typedef agg::renderer_base<agg::pixfmt_rgba32_plain> ren_base;
     typedef agg::renderer_scanline_aa_solid<ren_base> renderer;
 
@@ -70,7 +72,10 @@ void agg_renderer<T>::process(polygon_symbolizer const& sym,
         if (geom.num_points() > 2)
         {
             path_type path(t_,geom,prj_trans);
-            ras_ptr->add_path(path);
+            filter_type filtered(path,
+                                 sym.get_simplify_tolerance() * scale_factor_,
+                                 sym.get_simplify_algorithm());
+            ras_ptr->add_path(filtered);
             if (writer.first) writer.first->add_polygon(path, feature, t_, writer.second);
         }
     }
@@ -123,7 +123,7 @@ void  agg_renderer<T>::process(shield_symbolizer const& sym,
             stroker_ptr strk = font_manager_.get_stroker();
             if (strk && faces->size() > 0)
             {
-                text_renderer<T> text_ren(pixmap_, faces, *strk);
+                text_renderer<T> text_ren(pixmap_, faces, *strk, font_manager_.get_glyph_cache());
                 
                 text_ren.set_pixel_size(sym.get_text_size() * scale_factor_);
                 text_ren.set_fill(sym.get_fill());
@@ -150,7 +150,6 @@ void  agg_renderer<T>::process(shield_symbolizer const& sym,
                         if (how_placed == POINT_PLACEMENT || how_placed == VERTEX_PLACEMENT)
                         {
                             // for every vertex, try and place a shield/text
-                            geom.rewind(0);
                             for( unsigned jj = 0; jj < geom.num_points(); jj++ )
                             {
                                 double label_x;
@@ -160,7 +159,7 @@ void  agg_renderer<T>::process(shield_symbolizer const& sym,
                                 text_placement.avoid_edges = sym.get_avoid_edges();
                                 text_placement.allow_overlap = sym.get_allow_overlap();
                                 if( how_placed == VERTEX_PLACEMENT )
-                                    geom.vertex(&label_x,&label_y);  // by vertex
+                                    geom.get_vertex(jj,&label_x,&label_y);  // by vertex
                                 else
                                     geom.middle_point(&label_x, &label_y);  // by middle of line
                                 
@@ -272,7 +271,7 @@ void  agg_renderer<T>::process(shield_symbolizer const& sym,
             stroker_ptr strk = font_manager_.get_stroker();
             if (strk && faces->size() > 0)
             {
-                text_renderer<T> ren(pixmap_, faces, *strk);
+                text_renderer<T> ren(pixmap_, faces, *strk, font_manager_.get_glyph_cache());
                 
                 ren.set_pixel_size(sym.get_text_size() * scale_factor_);
                 ren.set_fill(sym.get_fill());
@@ -302,7 +301,6 @@ void  agg_renderer<T>::process(shield_symbolizer const& sym,
                         if (how_placed == POINT_PLACEMENT || how_placed == VERTEX_PLACEMENT)
                         {
                             // for every vertex, try and place a shield/text
-                            geom.rewind(0);
                             placement text_placement(info, sym, w, h, false);
                             text_placement.avoid_edges = sym.get_avoid_edges();
                             text_placement.allow_overlap = sym.get_allow_overlap();
@@ -315,7 +313,7 @@ void  agg_renderer<T>::process(shield_symbolizer const& sym,
                                 double z=0.0;
                                 
                                 if( how_placed == VERTEX_PLACEMENT )
-                                    geom.vertex(&label_x,&label_y);  // by vertex
+                                    geom.get_vertex(jj,&label_x,&label_y);  // by vertex
                                 else
                                     geom.label_position(&label_x, &label_y);  // by middle of line or by point
                                 prj_trans.backward(label_x,label_y, z);
@@ -24,6 +24,9 @@
 // mapnik
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/agg_rasterizer.hpp>
+
+// stl
+#include <algorithm>
 /*
 #include <mapnik/unicode.hpp>
 #include <mapnik/placement_finder.hpp>
@@ -74,26 +77,39 @@ void agg_renderer<T>::process(text_symbolizer const& sym,
         stroker_ptr strk = font_manager_.get_stroker();
         if (faces->size() > 0 && strk)
         {
-            text_renderer<T> ren(pixmap_, faces, *strk);
+            // labels with a priority are only placed at the end of the
+            // layer, metawriters need the feature so those are not deferred
+            bool deferred = sym.get_priority() && !sym.get_metawriter().first;
+            double priority = 0.0;
+            if (deferred)
+            {
+                value_type result = boost::apply_visitor(evaluate<Feature,value_type>(feature),*sym.get_priority());
+                priority = result.to_double();
+                scratch_detector_.clear();
+            }
+
+            text_renderer<T> ren(pixmap_, faces, *strk, font_manager_.get_glyph_cache());
             ren.set_pixel_size(sym.get_text_size() * scale_factor_);
             ren.set_fill(fill);
             ren.set_halo_fill(sym.get_halo_fill());
             ren.set_halo_radius(sym.get_halo_radius() * scale_factor_);
             ren.set_opacity(sym.get_text_opacity());
 
-            placement_finder<label_collision_detector4> finder(detector_);
+            placement_finder<label_collision_detector4> finder(deferred ? scratch_detector_ : detector_);
 
-            string_info info(text);
+            boost::shared_ptr<string_info> info(new string_info(text));
 
-            faces->get_string_info(info);
+            faces->get_string_info(*info);
             unsigned num_geom = feature.num_geometries();
             for (unsigned i=0;i<num_geom;++i)
             {
                 geometry2d const& geom = feature.get_geometry(i);
                 if (geom.num_points() > 0) // don't bother with empty geometries
                 {           
-                    placement text_placement(info,sym);
+                    boost::shared_ptr<placement> placement_ptr(new placement(*info,sym));
+                    placement & text_placement = *placement_ptr;
                     text_placement.avoid_edges = sym.get_avoid_edges();
+                    text_placement.record_envelopes = deferred;
                     if (sym.get_label_placement() == POINT_PLACEMENT)
                     {
                         double label_x, label_y, z=0.0;
@@ -121,6 +137,15 @@ void agg_renderer<T>::process(text_symbolizer const& sym,
                         finder.find_line_placements<path_type>(text_placement,path);
                     }
 
+                    if (deferred)
+                    {
+                        if (text_placement.placements.size() > 0)
+                        {
+                            deferred_label label = { &sym, faces, info, placement_ptr, priority };
+                            deferred_labels_.push_back(label);
+                        }
+                        continue;
+                    }
 
                     for (unsigned int ii = 0; ii < text_placement.placements.size(); ++ii)
                     {
@@ -142,9 +167,73 @@ void agg_renderer<T>::process(text_symbolizer const& sym,
     }
 }
 
+namespace {
+
+template <typename Label>
+bool higher_priority(Label const& a, Label const& b)
+{
+    return a.priority > b.priority;
+}
+
+}
+
+template <typename T>
+void agg_renderer<T>::render_deferred_labels()
+{
+    if (deferred_labels_.empty()) return;
+
+    // highest priority first, ties keep the feature order
+    std::stable_sort(deferred_labels_.begin(), deferred_labels_.end(),
+                     higher_priority<deferred_label>);
+
+    stroker_ptr strk = font_manager_.get_stroker();
+    typename std::vector<deferred_label>::const_iterator itr = deferred_labels_.begin();
+    typename std::vector<deferred_label>::const_iterator end = deferred_labels_.end();
+    for ( ; itr != end; ++itr)
+    {
+        text_symbolizer const& sym = *itr->sym;
+        UnicodeString const& text = itr->info->get_string();
+        bool point = sym.get_label_placement() == POINT_PLACEMENT;
+
+        text_renderer<T> ren(pixmap_, itr->faces, *strk, font_manager_.get_glyph_cache());
+        ren.set_pixel_size(sym.get_text_size() * scale_factor_);
+        ren.set_fill(sym.get_fill());
+        ren.set_halo_fill(sym.get_halo_fill());
+        ren.set_halo_radius(sym.get_halo_radius() * scale_factor_);
+        ren.set_opacity(sym.get_text_opacity());
+
+        boost::ptr_vector<placement_element> & placements = itr->placements->placements;
+        for (unsigned ii = 0; ii < placements.size(); ++ii)
+        {
+            // the same collision tests the placement finder applies
+            std::vector<box2d<double> > const& envelopes = placements[ii].envelopes;
+            bool ok = true;
+            if (!point || !sym.get_allow_overlap())
+            {
+                for (unsigned k = 0; ok && k < envelopes.size(); ++k)
+                {
+                    ok = point ? detector_.has_point_placement(envelopes[k], sym.get_minimum_distance())
+                        : detector_.has_placement(envelopes[k], text, sym.get_minimum_distance());
+                }
+            }
+            if (!ok) continue;
+
+            for (unsigned k = 0; k < envelopes.size(); ++k)
+            {
+                detector_.insert(envelopes[k], text);
+            }
+            ren.prepare_glyphs(&placements[ii]);
+            ren.render(placements[ii].starting_x, placements[ii].starting_y);
+        }
+    }
+    deferred_labels_.clear();
+}
+
 template void agg_renderer<image_32>::process(text_symbolizer const&,
                                               Feature const&,
                                               proj_transform const&);
 
+template void agg_renderer<image_32>::render_deferred_labels();
+
 }
  
@@ -0,0 +1,110 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/arena.hpp>
+// boost
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/tss.hpp>
+#endif
+// stl
+#include <cstdlib>
+
+namespace mapnik
+{
+
+namespace {
+#ifdef MAPNIK_THREADSAFE
+// the arena pointer is not owned by the thread
+void no_cleanup(arena *) {}
+boost::thread_specific_ptr<arena> current_arena(&no_cleanup);
+#else
+arena * current_arena = 0;
+#endif
+}
+
+arena::arena(std::size_t chunk_size)
+    : chunk_size_(chunk_size),
+      pos_(0),
+      end_(0),
+      used_(0) {}
+
+arena::~arena()
+{
+    release();
+}
+
+void * arena::allocate_chunk(std::size_t size)
+{
+    used_ += size;
+    // big requests get a chunk of their own and leave the current one alone
+    if (size > chunk_size_ / 4)
+    {
+        char * chunk = static_cast<char*>(::operator new(size));
+        chunks_.push_back(chunk);
+        return chunk;
+    }
+    char * chunk = static_cast<char*>(::operator new(chunk_size_));
+    chunks_.push_back(chunk);
+    pos_ = chunk + size;
+    end_ = chunk + chunk_size_;
+    return chunk;
+}
+
+void arena::release()
+{
+    for (std::vector<char*>::iterator itr = chunks_.begin(); itr != chunks_.end(); ++itr)
+    {
+        ::operator delete(*itr);
+    }
+    chunks_.clear();
+    pos_ = 0;
+    end_ = 0;
+    used_ = 0;
+}
+
+std::size_t arena::used() const
+{
+    return used_;
+}
+
+arena * arena::current()
+{
+#ifdef MAPNIK_THREADSAFE
+    return current_arena.get();
+#else
+    return current_arena;
+#endif
+}
+
+void arena::set_current(arena * a)
+{
+#ifdef MAPNIK_THREADSAFE
+    current_arena.reset(a);
+#else
+    current_arena = a;
+#endif
+}
+
+}
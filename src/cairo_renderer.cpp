@@ -33,6 +33,7 @@
 #include <mapnik/config_error.hpp>
 #include <mapnik/parse_path.hpp>
 #include <mapnik/image_cache.hpp>
+#include <mapnik/vertex_filter.hpp>
 // cairo
 #include <cairomm/context.h>
 #include <cairomm/surface.h>
@@ -483,7 +484,7 @@ cairo_renderer_base::cairo_renderer_base(Map const& m, Cairo::RefPtr<Cairo::Cont
       font_engine_(new freetype_engine()),
       font_manager_(*font_engine_),
       face_manager_(font_engine_,font_manager_),
-      detector_(box2d<double>(-m.buffer_size() ,-m.buffer_size() , m.width() + m.buffer_size() ,m.height() + m.buffer_size()))
+      detector_(box2d<double>(-m.buffer_size() ,-m.buffer_size() , m.width() + m.buffer_size() ,m.height() + m.buffer_size()), m.label_detector())
 {
 #ifdef MAPNIK_DEBUG
     std::clog << "scale=" << m.scale() << "\n";
@@ -569,6 +570,7 @@ void cairo_renderer_base::process(polygon_symbolizer const& sym,
                                   proj_transform const& prj_trans)
 {
     typedef coord_transform2<CoordTransform,geometry2d> path_type;
+    typedef vertex_filter<path_type> filter_type;
 
     cairo_context context(context_);
 
@@ -581,8 +583,9 @@ void cairo_renderer_base::process(polygon_symbolizer const& sym,
         if (geom.num_points() > 2)
         {
             path_type path(t_, geom, prj_trans);
+            filter_type filtered(path, sym.get_simplify_tolerance(), sym.get_simplify_algorithm());
 
-            context.add_path(path);
+            context.add_path(filtered);
             context.fill();
         }
     }
@@ -619,13 +622,13 @@ void cairo_renderer_base::process(building_symbolizer const& sym,
             std::deque<segment_t> face_segments;
             double x0(0);
             double y0(0);
-            unsigned cm = geom.vertex(&x0, &y0);
+            unsigned cm = geom.get_vertex(0,&x0, &y0);
 
             for (unsigned j = 1; j < geom.num_points(); ++j)
             {
                 double x,y;
 
-                cm = geom.vertex(&x,&y);
+                cm = geom.get_vertex(j,&x,&y);
 
                 if (cm == SEG_MOVETO)
                 {
@@ -667,12 +670,11 @@ void cairo_renderer_base::process(building_symbolizer const& sym,
 
             }
 
-            geom.rewind(0);
 
             for (unsigned j = 0; j < geom.num_points(); ++j)
             {
                 double x, y;
-                unsigned cm = geom.vertex(&x, &y);
+                unsigned cm = geom.get_vertex(j,&x, &y);
 
                 if (cm == SEG_MOVETO)
                 {
@@ -704,6 +706,7 @@ void cairo_renderer_base::process(line_symbolizer const& sym,
                                   proj_transform const& prj_trans)
 {
     typedef coord_transform2<CoordTransform,geometry2d> path_type;
+    typedef vertex_filter<path_type> filter_type;
 
     cairo_context context(context_);
     mapnik::stroke const& stroke_ = sym.get_stroke();
@@ -718,6 +721,7 @@ void cairo_renderer_base::process(line_symbolizer const& sym,
         {
             cairo_context context(context_);
             path_type path(t_, geom, prj_trans);
+            filter_type filtered(path, sym.get_simplify_tolerance(), sym.get_simplify_algorithm());
 
             if (stroke_.has_dash())
             {
@@ -728,7 +732,7 @@ void cairo_renderer_base::process(line_symbolizer const& sym,
             context.set_line_cap(stroke_.get_line_cap());
             context.set_miter_limit(4.0);
             context.set_line_width(stroke_.get_width());
-            context.add_path(path);
+            context.add_path(filtered);
             context.stroke();
         }
     }
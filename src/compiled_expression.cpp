@@ -0,0 +1,166 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/compiled_expression.hpp>
+// boost
+#include <boost/variant.hpp>
+
+namespace mapnik
+{
+
+template <typename Tag> struct opcode_of;
+template <> struct opcode_of<tags::plus> { static const compiled_expression::opcode value = compiled_expression::add; };
+template <> struct opcode_of<tags::minus> { static const compiled_expression::opcode value = compiled_expression::sub; };
+template <> struct opcode_of<tags::mult> { static const compiled_expression::opcode value = compiled_expression::mult; };
+template <> struct opcode_of<tags::div> { static const compiled_expression::opcode value = compiled_expression::div; };
+template <> struct opcode_of<tags::mod> { static const compiled_expression::opcode value = compiled_expression::mod; };
+template <> struct opcode_of<tags::less> { static const compiled_expression::opcode value = compiled_expression::less; };
+template <> struct opcode_of<tags::less_equal> { static const compiled_expression::opcode value = compiled_expression::less_equal; };
+template <> struct opcode_of<tags::greater> { static const compiled_expression::opcode value = compiled_expression::greater; };
+template <> struct opcode_of<tags::greater_equal> { static const compiled_expression::opcode value = compiled_expression::greater_equal; };
+template <> struct opcode_of<tags::equal_to> { static const compiled_expression::opcode value = compiled_expression::equal_to; };
+template <> struct opcode_of<tags::not_equal_to> { static const compiled_expression::opcode value = compiled_expression::not_equal_to; };
+
+struct expression_compiler : boost::static_visitor<void>
+{
+    typedef compiled_expression::instruction instruction;
+
+    explicit expression_compiler(compiled_expression & expr)
+        : expr_(expr),
+          depth_(0),
+          max_depth_(0) {}
+
+    void operator() (value_type const& x)
+    {
+        emit(compiled_expression::push_value, expr_.values_.size());
+        expr_.values_.push_back(x);
+        push();
+    }
+
+    void operator() (attribute const& attr)
+    {
+        std::size_t index = 0;
+        while (index < expr_.names_.size() && expr_.names_[index] != attr.name()) ++index;
+        if (index == expr_.names_.size()) expr_.names_.push_back(attr.name());
+        emit(compiled_expression::push_attribute, index);
+        push();
+    }
+
+    template <typename Tag>
+    void operator() (binary_node<Tag> const& x)
+    {
+        boost::apply_visitor(*this, x.left);
+        boost::apply_visitor(*this, x.right);
+        emit(opcode_of<Tag>::value, 0);
+        --depth_;
+    }
+
+    void operator() (binary_node<tags::logical_and> const& x)
+    {
+        short_circuit(compiled_expression::and_jump, x.left, x.right);
+    }
+
+    void operator() (binary_node<tags::logical_or> const& x)
+    {
+        short_circuit(compiled_expression::or_jump, x.left, x.right);
+    }
+
+    template <typename Tag>
+    void operator() (unary_node<Tag> const& x)
+    {
+        boost::apply_visitor(*this, x.expr);
+        emit(compiled_expression::logical_not, 0);
+    }
+
+    void operator() (regex_match_node const& x)
+    {
+        boost::apply_visitor(*this, x.expr);
+        emit(compiled_expression::regex_match, expr_.match_nodes_.size());
+        expr_.match_nodes_.push_back(&x);
+    }
+
+    void operator() (regex_replace_node const& x)
+    {
+        boost::apply_visitor(*this, x.expr);
+        emit(compiled_expression::regex_replace, expr_.replace_nodes_.size());
+        expr_.replace_nodes_.push_back(&x);
+    }
+
+    std::size_t max_depth() const
+    {
+        return max_depth_;
+    }
+
+private:
+    void short_circuit(compiled_expression::opcode op, expr_node const& left, expr_node const& right)
+    {
+        boost::apply_visitor(*this, left);
+        std::size_t jump = expr_.code_.size();
+        emit(op, 0);
+        --depth_;
+        boost::apply_visitor(*this, right);
+        emit(compiled_expression::to_bool, 0);
+        expr_.code_[jump].arg = expr_.code_.size();
+    }
+
+    void emit(compiled_expression::opcode op, std::size_t arg)
+    {
+        expr_.code_.push_back(instruction(op, arg));
+    }
+
+    void push()
+    {
+        if (++depth_ > max_depth_) max_depth_ = depth_;
+    }
+
+    compiled_expression & expr_;
+    std::size_t depth_;
+    std::size_t max_depth_;
+};
+
+const std::size_t compiled_expression::unbound;
+
+compiled_expression::compiled_expression(expression_ptr const& expr)
+    : expr_(expr),
+      bound_size_(0)
+{
+    expression_compiler compiler(*this);
+    boost::apply_visitor(compiler, *expr_);
+    stack_.reserve(compiler.max_depth());
+    slots_.resize(names_.size(), unbound);
+}
+
+void compiled_expression::bind(context_ptr const& ctx) const
+{
+    ctx_ = ctx;
+    bound_size_ = ctx->size();
+    for (std::size_t i = 0; i < names_.size(); ++i)
+    {
+        context::iterator itr = ctx->find(names_[i]);
+        slots_[i] = itr != ctx->end() ? itr->second : unbound;
+    }
+}
+
+}
@@ -25,6 +25,7 @@
 #include <mapnik/datasource_cache.hpp>
 
 #include <mapnik/config_error.hpp>
+#include <mapnik/ptree_helpers.hpp>
 
 // boost
 #include <boost/version.hpp>
@@ -62,8 +63,63 @@ datasource_cache::~datasource_cache()
 std::map<string,boost::shared_ptr<PluginInfo> > datasource_cache::plugins_;
 bool datasource_cache::registered_=false;
 std::vector<std::string> datasource_cache::plugin_directories_;
-    
-datasource_ptr datasource_cache::create(const parameters& params) 
+bool datasource_cache::shared_instances_=false;
+std::map<param_map,boost::weak_ptr<datasource> > datasource_cache::instances_;
+
+#ifdef MAPNIK_THREADSAFE
+static boost::mutex instances_mutex;
+#endif
+
+void datasource_cache::set_shared_instances(bool shared)
+{
+    shared_instances_ = shared;
+}
+
+bool datasource_cache::shared_instances()
+{
+    return shared_instances_;
+}
+
+datasource_ptr datasource_cache::create(const parameters& params)
+{
+    boost::optional<mapnik::boolean> shared = params.get<mapnik::boolean>("shared_instance");
+    if (shared ? !*shared : !shared_instances_)
+    {
+        return create_instance(params);
+    }
+
+    // creation happens under the lock so that concurrent requests for the
+    // same parameters end up with a single instance
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex::scoped_lock lock(instances_mutex);
+#endif
+    std::map<param_map,boost::weak_ptr<datasource> >::iterator itr = instances_.find(params);
+    if (itr != instances_.end())
+    {
+        if (datasource_ptr ds = itr->second.lock())
+        {
+            return ds;
+        }
+    }
+
+    // drop entries of instances nobody holds anymore
+    for (itr = instances_.begin(); itr != instances_.end();)
+    {
+        if (itr->second.expired()) instances_.erase(itr++);
+        else ++itr;
+    }
+
+    // without an explicit 'shared_instance' only datasources that can be
+    // queried from several threads at once are handed out again
+    datasource_ptr ds = create_instance(params);
+    if (shared || ds->thread_safe())
+    {
+        instances_[params] = ds;
+    }
+    return ds;
+}
+
+datasource_ptr datasource_cache::create_instance(const parameters& params)
 {
     boost::optional<std::string> type = params.get<std::string>("type");
     if ( ! type)
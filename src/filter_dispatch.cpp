@@ -0,0 +1,193 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/filter_dispatch.hpp>
+// boost
+#include <boost/functional/hash.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/variant.hpp>
+// stl
+#include <map>
+
+namespace mapnik
+{
+
+namespace {
+
+struct to_dispatch_key : boost::static_visitor<boost::optional<dispatch_key> >
+{
+    boost::optional<dispatch_key> make(dispatch_key::key_type type, double number) const
+    {
+        dispatch_key key;
+        key.type = type;
+        // -0.0 == 0.0 but would hash differently
+        key.number = number == 0.0 ? 0.0 : number;
+        return key;
+    }
+
+    boost::optional<dispatch_key> operator() (value_null) const
+    {
+        return boost::optional<dispatch_key>();
+    }
+
+    boost::optional<dispatch_key> operator() (bool val) const
+    {
+        return make(dispatch_key::boolean, val ? 1.0 : 0.0);
+    }
+
+    boost::optional<dispatch_key> operator() (int val) const
+    {
+        return make(dispatch_key::numeric, val);
+    }
+
+    boost::optional<dispatch_key> operator() (double val) const
+    {
+        return make(dispatch_key::numeric, val);
+    }
+
+    boost::optional<dispatch_key> operator() (UnicodeString const& val) const
+    {
+        dispatch_key key;
+        key.type = dispatch_key::string;
+        key.number = 0.0;
+        key.str = val;
+        return key;
+    }
+};
+
+// matches [name] = constant and constant = [name]
+struct attribute_equality : boost::static_visitor<bool>
+{
+    attribute_equality(std::string & name, value_type & val)
+        : name_(name),
+          val_(val) {}
+
+    template <typename T>
+    bool operator() (T const&) const
+    {
+        return false;
+    }
+
+    bool operator() (binary_node<tags::equal_to> const& x) const
+    {
+        attribute const* attr = boost::get<attribute>(&x.left);
+        value_type const* val = boost::get<value_type>(&x.right);
+        if (!attr || !val)
+        {
+            attr = boost::get<attribute>(&x.right);
+            val = boost::get<value_type>(&x.left);
+        }
+        if (!attr || !val) return false;
+        name_ = attr->name();
+        val_ = *val;
+        return true;
+    }
+
+    std::string & name_;
+    value_type & val_;
+};
+
+}
+
+std::size_t hash_value(dispatch_key const& key)
+{
+    std::size_t seed = 0;
+    boost::hash_combine(seed, static_cast<int>(key.type));
+    if (key.type == dispatch_key::string)
+        boost::hash_combine(seed, static_cast<std::size_t>(key.str.hashCode()));
+    else
+        boost::hash_combine(seed, key.number);
+    return seed;
+}
+
+boost::optional<dispatch_key> make_dispatch_key(value_type const& v)
+{
+    return boost::apply_visitor(to_dispatch_key(), v.base());
+}
+
+const std::size_t filter_dispatch::min_dispatch_rules;
+
+filter_dispatch::filter_dispatch(std::vector<expression_ptr> const& filters)
+{
+    // find the attribute most rules compare to a constant
+    std::vector<std::string> names(filters.size());
+    std::vector<boost::optional<dispatch_key> > keys(filters.size());
+    std::map<std::string,std::size_t> counts;
+    for (std::size_t i = 0; i < filters.size(); ++i)
+    {
+        value_type val;
+        if (filters[i] && boost::apply_visitor(attribute_equality(names[i], val), *filters[i]))
+        {
+            keys[i] = make_dispatch_key(val);
+            if (keys[i]) ++counts[names[i]];
+        }
+    }
+
+    std::size_t best = 0;
+    for (std::map<std::string,std::size_t>::const_iterator itr = counts.begin();
+         itr != counts.end(); ++itr)
+    {
+        if (itr->second > best)
+        {
+            best = itr->second;
+            attribute_name_ = itr->first;
+        }
+    }
+
+    if (best < min_dispatch_rules)
+    {
+        attribute_name_.clear();
+        for (std::size_t i = 0; i < filters.size(); ++i)
+        {
+            others_.push_back(candidate(i, false));
+        }
+        return;
+    }
+
+    attribute_.reset(new compiled_expression(boost::make_shared<expr_node>(attribute(attribute_name_))));
+
+    // every bucket gets its own rules and all rules that are not
+    // dispatched, merged in rule order
+    for (std::size_t i = 0; i < filters.size(); ++i)
+    {
+        bool dispatched = keys[i] && names[i] == attribute_name_;
+        if (dispatched)
+        {
+            candidates & bucket = table_[*keys[i]];
+            if (bucket.empty()) bucket = others_;
+            bucket.push_back(candidate(i, true));
+        }
+        else
+        {
+            others_.push_back(candidate(i, false));
+            for (table_type::iterator itr = table_.begin(); itr != table_.end(); ++itr)
+            {
+                itr->second.push_back(candidate(i, false));
+            }
+        }
+    }
+}
+
+}
@@ -27,6 +27,13 @@
 // boost
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+// stl
+#include <cmath>
+#include <cstring>
 
 namespace mapnik
 {
@@ -72,7 +79,17 @@ bool freetype_engine::register_font(std::string const& file_name)
     }
       
     FT_Face face;
-    error = FT_New_Face (library,file_name.c_str(),0,&face);
+    mapped_region_ptr region = map_font_file(file_name);
+    if (region)
+    {
+        error = FT_New_Memory_Face (library,
+                                    static_cast<FT_Byte const*>(region->get_address()),
+                                    region->get_size(),0,&face);
+    }
+    else
+    {
+        error = FT_New_Face (library,file_name.c_str(),0,&face);
+    }
     if (error)
     {
         FT_Done_FreeType(library);
@@ -80,11 +97,34 @@ bool freetype_engine::register_font(std::string const& file_name)
     }
     std::string name = std::string(face->family_name) + " " + std::string(face->style_name);
     name2file_.insert(std::make_pair(name,file_name));
+    if (region) file_cache_.insert(std::make_pair(file_name,region));
     FT_Done_Face(face );   
     FT_Done_FreeType(library);
     return true;
 }
 
+mapped_region_ptr freetype_engine::map_font_file(std::string const& file_name)
+{
+    // callers hold mutex_
+    std::map<std::string,mapped_region_ptr>::const_iterator itr = file_cache_.find(file_name);
+    if (itr != file_cache_.end())
+    {
+        return itr->second;
+    }
+    try
+    {
+        using namespace boost::interprocess;
+        file_mapping mapping(file_name.c_str(),read_only);
+        // the region stays valid after the file mapping is closed
+        return mapped_region_ptr(new mapped_region(mapping,read_only));
+    }
+    catch (boost::interprocess::interprocess_exception const&)
+    {
+        // fall back to letting FreeType read the file
+        return mapped_region_ptr();
+    }
+}
+
 bool freetype_engine::register_fonts(std::string const& dir, bool recurse)
 {
     boost::filesystem::path path(dir);
@@ -122,12 +162,33 @@ face_ptr freetype_engine::create_face(std::string const& family_name)
     itr = name2file_.find(family_name);
     if (itr != name2file_.end())
     {
+        mapped_region_ptr region;
+        {
+#ifdef MAPNIK_THREADSAFE
+            mutex::scoped_lock lock(mutex_);
+#endif
+            std::map<std::string,mapped_region_ptr>::const_iterator file = file_cache_.find(itr->second);
+            if (file != file_cache_.end()) region = file->second;
+        }
+
         FT_Face face;
-        FT_Error error = FT_New_Face (library_,itr->second.c_str(),0,&face);
+        FT_Error error;
+        if (region)
+        {
+            // the face only parses the shared mapping, the file data
+            // is neither read nor copied again
+            error = FT_New_Memory_Face (library_,
+                                        static_cast<FT_Byte const*>(region->get_address()),
+                                        region->get_size(),0,&face);
+        }
+        else
+        {
+            error = FT_New_Face (library_,itr->second.c_str(),0,&face);
+        }
 
         if (!error)
         {
-            return face_ptr (new font_face(face));
+            return face_ptr (new font_face(face,region));
         }
     }
     return face_ptr();
@@ -276,8 +337,153 @@ void font_face_set::get_string_info(string_info & info)
     info.set_dimensions(width, height);
 }
 
+std::size_t hash_value(glyph_cache::key const& k)
+{
+    std::size_t seed = 0;
+    boost::hash_combine(seed, static_cast<void*>(k.face));
+    boost::hash_combine(seed, k.size);
+    boost::hash_combine(seed, k.index);
+    boost::hash_combine(seed, k.angle);
+    boost::hash_combine(seed, k.dx);
+    boost::hash_combine(seed, k.dy);
+    boost::hash_combine(seed, k.halo);
+    return seed;
+}
+
+void glyph_cache::make_key(key & k, FT_Face face, unsigned size, unsigned index,
+                           double angle, FT_Vector & pos, FT_Fixed halo)
+{
+    // round the origin to the subpixel grid and split it into the whole
+    // pixel part and the offset the glyph is rendered at
+    pos.x = (pos.x + subpixel_step / 2) & ~FT_Pos(subpixel_step - 1);
+    pos.y = (pos.y + subpixel_step / 2) & ~FT_Pos(subpixel_step - 1);
+
+    int steps = static_cast<int>(std::floor(angle * angle_steps / (2 * M_PI) + 0.5)) % angle_steps;
+    if (steps < 0) steps += angle_steps;
+
+    k.face = face;
+    k.size = size;
+    k.index = index;
+    k.angle = steps;
+    k.dx = static_cast<int>(pos.x & 63);
+    k.dy = static_cast<int>(pos.y & 63);
+    k.halo = halo;
+}
+
+bool glyph_cache::load_glyph(key const& k)
+{
+    double a = k.angle * 2 * M_PI / angle_steps;
+    FT_Matrix matrix;
+    matrix.xx = (FT_Fixed)( std::cos( a ) * 0x10000L );
+    matrix.xy = (FT_Fixed)(-std::sin( a ) * 0x10000L );
+    matrix.yx = (FT_Fixed)( std::sin( a ) * 0x10000L );
+    matrix.yy = (FT_Fixed)( std::cos( a ) * 0x10000L );
+    FT_Vector delta;
+    delta.x = k.dx;
+    delta.y = k.dy;
+    FT_Set_Transform(k.face, &matrix, &delta);
+
+    return FT_Load_Glyph(k.face, k.index, FT_LOAD_NO_HINTING) == 0;
+}
+
+glyph_bitmap const* glyph_cache::get(FT_Face face, unsigned size, unsigned index,
+                                     double angle, FT_Vector & pos,
+                                     FT_Fixed halo, stroker & s)
+{
+    key k;
+    make_key(k, face, size, index, angle, pos, halo);
+    pos.x >>= 6;
+    pos.y >>= 6;
+
+    entries_t::const_iterator itr = entries_.find(k);
+    if (itr != entries_.end())
+    {
+        return itr->second.get();
+    }
+
+    if (!load_glyph(k))
+        return 0;
+
+    FT_Glyph image;
+    if (FT_Get_Glyph(face->glyph, &image))
+        return 0;
+
+    if (halo > 0)
+    {
+        s.init(halo / 64.0);
+        FT_Glyph_Stroke(&image, s.get(), 1);
+    }
+
+    if (FT_Glyph_To_Bitmap(&image, FT_RENDER_MODE_NORMAL, 0, 1))
+    {
+        FT_Done_Glyph(image);
+        return 0;
+    }
+
+    boost::shared_ptr<glyph_bitmap> bitmap(new glyph_bitmap);
+    FT_BitmapGlyph bit = (FT_BitmapGlyph)image;
+    bitmap->left = bit->left;
+    bitmap->top = bit->top;
+    bitmap->width = bit->bitmap.width;
+    bitmap->rows = bit->bitmap.rows;
+    bitmap->buffer.resize(bitmap->width * bitmap->rows);
+    for (unsigned row = 0; bitmap->width > 0 && row < bitmap->rows; ++row)
+    {
+        std::memcpy(&bitmap->buffer[row * bitmap->width],
+                    bit->bitmap.buffer + row * bit->bitmap.pitch,
+                    bitmap->width);
+    }
+    FT_Done_Glyph(image);
+
+    if (entries_.size() >= max_entries) entries_.clear();
+    entries_.insert(std::make_pair(k, bitmap));
+    return bitmap.get();
+}
+
+bool glyph_cache::get_bbox(FT_Face face, unsigned size, unsigned index,
+                           double angle, FT_Vector const& pos, FT_BBox & bbox)
+{
+    FT_Vector origin = pos;
+    key k;
+    make_key(k, face, size, index, angle, origin, 0);
+    // the outline moves by the subpixel offset unchanged, one box serves all
+    k.dx = k.dy = 0;
+
+    boxes_t::const_iterator itr = boxes_.find(k);
+    if (itr == boxes_.end())
+    {
+        if (!load_glyph(k))
+            return false;
+
+        FT_Glyph image;
+        if (FT_Get_Glyph(face->glyph, &image))
+            return false;
+        FT_BBox box;
+        FT_Glyph_Get_CBox(image, ft_glyph_bbox_subpixels, &box);
+        FT_Done_Glyph(image);
+
+        if (boxes_.size() >= max_entries) boxes_.clear();
+        itr = boxes_.insert(std::make_pair(k, box)).first;
+    }
+
+    FT_BBox const& box = itr->second;
+    if (box.xMin == box.xMax && box.yMin == box.yMax)
+    {
+        // empty glyphs have a zero box wherever they are drawn
+        bbox.xMin = bbox.yMin = bbox.xMax = bbox.yMax = 0;
+        return true;
+    }
+    // grid fitted as ft_glyph_bbox_pixels does it
+    bbox.xMin = (box.xMin + origin.x) >> 6;
+    bbox.yMin = (box.yMin + origin.y) >> 6;
+    bbox.xMax = (box.xMax + origin.x + 63) >> 6;
+    bbox.yMax = (box.yMax + origin.y + 63) >> 6;
+    return true;
+}
+
 #ifdef MAPNIK_THREADSAFE
 boost::mutex freetype_engine::mutex_;
 #endif
 std::map<std::string,std::string> freetype_engine::name2file_;
+std::map<std::string,mapped_region_ptr> freetype_engine::file_cache_;
 }
@@ -192,6 +192,12 @@ void map_parser::parse_map( Map & map, ptree const & pt )
                 map.set_buffer_size(*buffer_size);
             }
 
+            optional<label_detector_e> label_detector = get_opt_attr<label_detector_e>(map_node,"label_detector");
+            if (label_detector)
+            {
+                map.set_label_detector(*label_detector);
+            }
+
             // Check if relative paths should be interpreted as relative to/from XML location
             // Default is true, and map_parser::ensure_relative_to_xml will be called to modify path
             optional<boolean> paths_from_xml = get_opt_attr<boolean>(map_node, "paths_from_xml");
@@ -1067,6 +1073,12 @@ void map_parser::parse_text_symbolizer( rule_type & rule, ptree const & sym )
         {
             text_symbol.set_orientation(parse_expression(*orientation, "utf8"));
         }
+
+        optional<std::string> priority = get_opt_attr<std::string>(sym, "priority");
+        if (priority)
+        {
+            text_symbol.set_priority(parse_expression(*priority, "utf8"));
+        }
         
         if (fontset_name && face_name)
         {
@@ -1560,6 +1572,11 @@ void map_parser::parse_line_symbolizer( rule_type & rule, ptree const & sym )
         stroke strk;
         parse_stroke(strk,sym);
         line_symbolizer symbol = line_symbolizer(strk);
+        // simplify
+        optional<double> simplify = get_opt_attr<double>(sym, "simplify");
+        if (simplify) symbol.set_simplify_tolerance(*simplify);
+        optional<simplify_algorithm_e> algorithm = get_opt_attr<simplify_algorithm_e>(sym, "simplify-algorithm");
+        if (algorithm) symbol.set_simplify_algorithm(*algorithm);
 
         parse_metawriter_in_symbolizer(symbol, sym);
         rule.append(symbol);
@@ -1586,6 +1603,11 @@ void map_parser::parse_polygon_symbolizer( rule_type & rule, ptree const & sym )
         // gamma
         optional<double> gamma = get_opt_attr<double>(sym, "gamma");
         if (gamma)  poly_sym.set_gamma(*gamma);
+        // simplify
+        optional<double> simplify = get_opt_attr<double>(sym, "simplify");
+        if (simplify) poly_sym.set_simplify_tolerance(*simplify);
+        optional<simplify_algorithm_e> algorithm = get_opt_attr<simplify_algorithm_e>(sym, "simplify-algorithm");
+        if (algorithm) poly_sym.set_simplify_algorithm(*algorithm);
 
         parse_metawriter_in_symbolizer(poly_sym, sym);
         rule.append(poly_sym);
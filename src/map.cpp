@@ -60,19 +60,29 @@ static const char * aspect_fix_mode_strings[] = {
    
 IMPLEMENT_ENUM( aspect_fix_mode_e, aspect_fix_mode_strings );
 
+static const char * label_detector_strings[] = {
+    "quadtree",
+    "grid",
+    ""
+};
+
+IMPLEMENT_ENUM( label_detector_e, label_detector_strings );
+
 Map::Map()
     : width_(400),
       height_(400),
       srs_("+proj=longlat +ellps=WGS84 +datum=WGS84 +no_defs"),
       buffer_size_(0),
-      aspectFixMode_(GROW_BBOX) {}
+      aspectFixMode_(GROW_BBOX),
+      label_detector_(QUAD_TREE_DETECTOR) {}
     
 Map::Map(int width,int height, std::string const& srs)
     : width_(width),
       height_(height),
       srs_(srs),
       buffer_size_(0),
-      aspectFixMode_(GROW_BBOX) {}
+      aspectFixMode_(GROW_BBOX),
+      label_detector_(QUAD_TREE_DETECTOR) {}
    
 Map::Map(const Map& rhs)
     : width_(rhs.width_),
@@ -85,7 +95,8 @@ Map::Map(const Map& rhs)
       metawriters_(rhs.metawriters_),
       layers_(rhs.layers_),
       aspectFixMode_(rhs.aspectFixMode_),
-      currentExtent_(rhs.currentExtent_) {}
+      currentExtent_(rhs.currentExtent_),
+      label_detector_(rhs.label_detector_) {}
     
 Map& Map::operator=(const Map& rhs)
 {
@@ -100,6 +111,7 @@ Map& Map::operator=(const Map& rhs)
     metawriters_ = rhs.metawriters_;
     layers_=rhs.layers_;
     aspectFixMode_=rhs.aspectFixMode_;
+    label_detector_=rhs.label_detector_;
     return *this;
 }
    
@@ -310,6 +322,16 @@ int Map::buffer_size() const
 {
     return buffer_size_;
 }
+
+void Map::set_label_detector(label_detector_enum type)
+{
+    label_detector_ = type;
+}
+
+label_detector_enum Map::label_detector() const
+{
+    return label_detector_;
+}
    
 boost::optional<color> const& Map::background() const
 {
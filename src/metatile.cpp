@@ -0,0 +1,99 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/metatile.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/graphics.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/image_view.hpp>
+// stl
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace mapnik
+{
+
+std::vector<std::string> render_metatile(Map const& map,
+                                         box2d<double> const& extent,
+                                         unsigned tiles,
+                                         unsigned tile_size,
+                                         std::string const& format,
+                                         double scale_factor)
+{
+    if (tiles == 0 || tile_size == 0)
+    {
+        throw std::runtime_error("render_metatile: tiles and tile_size must be positive");
+    }
+
+    // the block is rendered as a square image, a non square extent would
+    // be silently widened by the map's aspect fix mode
+    double width = extent.width();
+    double height = extent.height();
+    if (!(width > 0.0 && height > 0.0) ||
+        std::fabs(width - height) > 1e-6 * std::max(width, height))
+    {
+        throw std::runtime_error("render_metatile: extent must be square");
+    }
+
+    unsigned margin = static_cast<unsigned>(std::max(0, map.buffer_size()));
+    unsigned inner = tiles * tile_size;
+    unsigned size = inner + 2 * margin;
+
+    // render the block and its margin as one map, a copy so that the
+    // caller's size and extent are left alone
+    Map m(map);
+    m.resize(size, size);
+    if (m.width() != size || m.height() != size)
+    {
+        throw std::runtime_error("render_metatile: metatile size out of range");
+    }
+
+    double dx = margin * extent.width() / inner;
+    double dy = margin * extent.height() / inner;
+    m.zoom_to_box(box2d<double>(extent.minx() - dx, extent.miny() - dy,
+                                extent.maxx() + dx, extent.maxy() + dy));
+
+    image_32 image(size, size);
+    agg_renderer<image_32> ren(m, image, scale_factor);
+    ren.apply();
+
+    std::vector<std::string> result;
+    result.reserve(tiles * tiles);
+    for (unsigned row = 0; row < tiles; ++row)
+    {
+        for (unsigned col = 0; col < tiles; ++col)
+        {
+            image_view<image_data_32> tile(margin + col * tile_size,
+                                           margin + row * tile_size,
+                                           tile_size, tile_size,
+                                           image.data());
+            result.push_back(save_to_string(tile, format));
+        }
+    }
+    return result;
+}
+
+}
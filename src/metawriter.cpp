@@ -104,16 +104,14 @@ void metawriter_json_stream::write_properties(Feature const& feature, metawriter
 {
     *f_ << "}," << //Close coordinates object
             "\n  \"properties\": {";
-    std::map<std::string, value> fprops = feature.props();
     int i = 0;
     BOOST_FOREACH(std::string p, properties)
     {
-        std::map<std::string, value>::const_iterator itr = fprops.find(p);
         std::string text;
-        if (itr != fprops.end())
+        if (feature.has_key(p))
         {
             //Property found
-            text = boost::replace_all_copy(boost::replace_all_copy(itr->second.to_string(), "\\", "\\\\"), "\"", "\\\"");
+            text = boost::replace_all_copy(boost::replace_all_copy(feature[p].to_string(), "\\", "\\\\"), "\"", "\\\"");
             if (i++) *f_ << ",";
             *f_ << "\n    \"" << p << "\":\"" << text << "\"";
         }
@@ -66,7 +66,8 @@ placement::placement(string_info & info_, shield_symbolizer const& sym,
       has_dimensions(has_dimensions_),
       allow_overlap(false),
       dimensions(std::make_pair(w,h)),
-      text_size(sym.get_text_size()) {}
+      text_size(sym.get_text_size()),
+      record_envelopes(false) {}
 
 placement::placement(string_info & info_,
                      text_symbolizer const& sym)
@@ -86,7 +87,8 @@ placement::placement(string_info & info_,
       has_dimensions(false),
       allow_overlap(sym.get_allow_overlap()),
       dimensions(),
-      text_size(sym.get_text_size())
+      text_size(sym.get_text_size()),
+      record_envelopes(false)
 {}
 
 
@@ -420,6 +422,8 @@ void placement_finder<DetectorT>::find_point_placement(placement & p,
     while( !c_envelopes.empty() )
     {
         p.envelopes.push( c_envelopes.front() );
+        if (p.record_envelopes)
+            current_placement->envelopes.push_back( c_envelopes.front() );
         c_envelopes.pop();
     }
 
@@ -564,6 +568,15 @@ void placement_finder<DetectorT>::find_line_placements(placement & p, PathT & sh
 
                         if (status) //We have successfully placed one
                         {
+                            if (p.record_envelopes)
+                            {
+                                std::queue<box2d<double> > envelopes(p.envelopes);
+                                while (!envelopes.empty())
+                                {
+                                    current_placement->envelopes.push_back(envelopes.front());
+                                    envelopes.pop();
+                                }
+                            }
                             p.placements.push_back(current_placement.release());
                             update_detector(p);
 
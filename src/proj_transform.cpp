@@ -28,16 +28,45 @@
 // proj4
 #include <proj_api.h>
 
+// with proj >= 4.8 source and destination projection own their
+// PROJ context and pj_transform does not need the global lock
+#if defined(MAPNIK_THREADSAFE) && PJ_VERSION < 480
+#define MAPNIK_PROJ_LOCK mutex::scoped_lock lock(projection::mutex_)
+#else
+#define MAPNIK_PROJ_LOCK
+#endif
+
 namespace mapnik {
     
 proj_transform::proj_transform(projection const& source, 
                                projection const& dest)
     : source_(source),
-      dest_(dest) 
+      dest_(dest),
+      wgs84_to_merc_(false),
+      merc_to_wgs84_(false),
+      merc_wrap_(true)
 {
     is_source_longlat_ = source_.is_geographic();
     is_dest_longlat_ = dest_.is_geographic();
     is_source_equal_dest_ = (source_ == dest_);
+    if (!is_source_equal_dest_)
+    {
+        boost::optional<well_known_srs_e> src_srs = source_.well_known();
+        boost::optional<well_known_srs_e> dest_srs = dest_.well_known();
+        if (src_srs && dest_srs)
+        {
+            if (*src_srs == WGS_84 && *dest_srs != WGS_84)
+            {
+                wgs84_to_merc_ = true;
+                merc_wrap_ = *dest_srs != G_MERC_OVER;
+            }
+            else if (*src_srs != WGS_84 && *dest_srs == WGS_84)
+            {
+                merc_to_wgs84_ = true;
+                merc_wrap_ = *src_srs != G_MERC_OVER;
+            }
+        }
+    }
 }
 
 bool proj_transform::equal() const
@@ -47,59 +76,82 @@ bool proj_transform::equal() const
 
 bool proj_transform::forward (double & x, double & y , double & z) const
 {
-    if (is_source_equal_dest_)
+    return forward(&x,&y,&z,1);
+}
+
+bool proj_transform::backward (double & x, double & y , double & z) const
+{
+    return backward(&x,&y,&z,1);
+}
+
+static inline void scale_coords(double * x, double * y, std::size_t point_count, std::size_t stride, double factor)
+{
+    for (std::size_t i = 0; i < point_count * stride; i += stride)
+    {
+        x[i] *= factor;
+        y[i] *= factor;
+    }
+}
+
+bool proj_transform::forward (double * x, double * y , double * z, std::size_t point_count, std::size_t stride) const
+{
+    if (is_source_equal_dest_ || point_count == 0)
         return true;
 
+    if (wgs84_to_merc_)
+        return lonlat2merc(x,y,point_count,stride,merc_wrap_);
+    if (merc_to_wgs84_)
+        return merc2lonlat(x,y,point_count,stride,merc_wrap_);
+
     if (is_source_longlat_)
     {
-        x *= DEG_TO_RAD;
-        y *= DEG_TO_RAD;
+        scale_coords(x,y,point_count,stride,DEG_TO_RAD);
     }
 
-#ifdef MAPNIK_THREADSAFE
-    mutex::scoped_lock lock(projection::mutex_);
-#endif
-        
-    if (pj_transform( source_.proj_, dest_.proj_, 1, 
-                      0, &x,&y,&z) != 0)
     {
-        return false;
+        MAPNIK_PROJ_LOCK;
+        if (pj_transform( source_.proj_, dest_.proj_, point_count, 
+                          stride, x,y,z) != 0)
+        {
+            return false;
+        }
     }
         
     if (is_dest_longlat_)
     {
-        x *= RAD_TO_DEG;
-        y *= RAD_TO_DEG;
+        scale_coords(x,y,point_count,stride,RAD_TO_DEG);
     }
         
     return true;
 } 
         
-bool proj_transform::backward (double & x, double & y , double & z) const
+bool proj_transform::backward (double * x, double * y , double * z, std::size_t point_count, std::size_t stride) const
 {
-    if (is_source_equal_dest_)
+    if (is_source_equal_dest_ || point_count == 0)
         return true;
+
+    if (wgs84_to_merc_)
+        return merc2lonlat(x,y,point_count,stride,merc_wrap_);
+    if (merc_to_wgs84_)
+        return lonlat2merc(x,y,point_count,stride,merc_wrap_);
       
     if (is_dest_longlat_)
     {
-        x *= DEG_TO_RAD;
-        y *= DEG_TO_RAD;
+        scale_coords(x,y,point_count,stride,DEG_TO_RAD);
     }
         
-#ifdef MAPNIK_THREADSAFE
-    mutex::scoped_lock lock(projection::mutex_);
-#endif
-
-    if (pj_transform( dest_.proj_, source_.proj_, 1, 
-                      0, &x,&y,&z) != 0)
     {
-        return false;
+        MAPNIK_PROJ_LOCK;
+        if (pj_transform( dest_.proj_, source_.proj_, point_count, 
+                          stride, x,y,z) != 0)
+        {
+            return false;
+        }
     }
         
     if (is_source_longlat_)
     {
-        x *= RAD_TO_DEG;
-        y *= RAD_TO_DEG;
+        scale_coords(x,y,point_count,stride,RAD_TO_DEG);
     }
         
     return true;
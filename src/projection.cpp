@@ -28,6 +28,14 @@
 // proj4
 #include <proj_api.h>
 
+// proj >= 4.8 provides per-object contexts (projCtx) and no longer
+// needs a process wide lock around pj_fwd/pj_inv/pj_transform
+#if defined(MAPNIK_THREADSAFE) && PJ_VERSION < 480
+#define MAPNIK_PROJ_LOCK mutex::scoped_lock lock(mutex_)
+#else
+#define MAPNIK_PROJ_LOCK
+#endif
+
 namespace mapnik {
 
 #ifdef MAPNIK_THREADSAFE
@@ -35,13 +43,17 @@ boost::mutex projection::mutex_;
 #endif
    
 projection::projection(std::string const& params)
-    : params_(params)
+    : params_(params),
+      proj_(0),
+      proj_ctx_(0)
 { 
     init(); //
 }
     
 projection::projection(projection const& rhs)
-    : params_(rhs.params_) 
+    : params_(rhs.params_),
+      proj_(0),
+      proj_ctx_(0)
 {
     init(); //
 }
@@ -77,12 +89,15 @@ std::string const& projection::params() const
 {
     return params_;
 }
+
+boost::optional<well_known_srs_e> projection::well_known() const
+{
+    return well_known_;
+}
     
 void projection::forward(double & x, double &y ) const
 {
-#ifdef MAPNIK_THREADSAFE
-    mutex::scoped_lock lock(mutex_);
-#endif
+    MAPNIK_PROJ_LOCK;
     projUV p;
     p.u = x * DEG_TO_RAD;
     p.v = y * DEG_TO_RAD;
@@ -98,9 +113,7 @@ void projection::forward(double & x, double &y ) const
     
 void projection::inverse(double & x,double & y) const
 {
-#ifdef MAPNIK_THREADSAFE
-    mutex::scoped_lock lock(mutex_);
-#endif
+    MAPNIK_PROJ_LOCK;
     if (is_geographic_)
     {
         x *=DEG_TO_RAD;
@@ -116,30 +129,46 @@ void projection::inverse(double & x,double & y) const
     
 projection::~projection() 
 {
-#ifdef MAPNIK_THREADSAFE
-    mutex::scoped_lock lock(mutex_);
-#endif
+    MAPNIK_PROJ_LOCK;
     if (proj_) pj_free(proj_);
+#if PJ_VERSION >= 480
+    if (proj_ctx_) pj_ctx_free(proj_ctx_);
+#endif
 }
     
 void projection::init()
 {
 // Based on http://trac.osgeo.org/proj/wiki/ThreadSafety
-// you could think pj_init was threadsafe in version 4.7.0
-// but its certainly not, and must only be in >= 4.7 with
-// usage of projCtx per thread
-//#if PJ_VERSION < 470 && MAPNIK_THREADSAFE
-//    mutex::scoped_lock lock(mutex_);
-//#endif
+// pj_init is not threadsafe before 4.8, from 4.8 on every
+// projection gets its own projCtx and the lock is only
+// kept for initialisation which is rare compared to the
+// per vertex transformations.
+#ifdef MAPNIK_THREADSAFE
     mutex::scoped_lock lock(mutex_);
+#endif
+#if PJ_VERSION >= 480
+    proj_ctx_ = pj_ctx_alloc();
+    proj_ = pj_init_plus_ctx(proj_ctx_, params_.c_str());
+    if (!proj_)
+    {
+        if (proj_ctx_) pj_ctx_free(proj_ctx_);
+        proj_ctx_ = 0;
+        throw proj_init_error(params_);
+    }
+#else
     proj_=pj_init_plus(params_.c_str());
     if (!proj_) throw proj_init_error(params_);
+#endif
     is_geographic_ = pj_is_latlong(proj_) ? true : false;
+    well_known_ = is_well_known_srs(params_);
 }
     
 void projection::swap (projection& rhs)
 {
     std::swap(params_,rhs.params_);
-    init ();
+    std::swap(proj_,rhs.proj_);
+    std::swap(proj_ctx_,rhs.proj_ctx_);
+    std::swap(is_geographic_,rhs.is_geographic_);
+    std::swap(well_known_,rhs.well_known_);
 }
 }
@@ -101,6 +101,7 @@ public:
 
         const stroke & strk =  sym.get_stroke();
         add_stroke_attributes(sym_node, strk);
+        add_simplify_attributes(sym_node, sym);
         add_metawriter_attributes(sym_node, sym);
     }
         
@@ -132,6 +133,7 @@ public:
         {
             set_attr( sym_node, "gamma", sym.get_gamma() );
         }
+        add_simplify_attributes(sym_node, sym);
         add_metawriter_attributes(sym_node, sym);
     }
 
@@ -215,6 +217,11 @@ public:
                               ptree()))->second;
 
         add_font_attributes( sym_node, sym);
+        expression_ptr const& priority = sym.get_priority();
+        if (priority)
+        {
+            set_attr( sym_node, "priority", to_expression_string(*priority) );
+        }
         add_metawriter_attributes(sym_node, sym);
     }
 
@@ -533,6 +540,20 @@ private:
         }
                 
     }
+    template <typename Symbolizer>
+    void add_simplify_attributes(ptree & node, Symbolizer const& sym)
+    {
+        Symbolizer dfl;
+        if ( sym.get_simplify_tolerance() != dfl.get_simplify_tolerance() || explicit_defaults_ )
+        {
+            set_attr( node, "simplify", sym.get_simplify_tolerance() );
+        }
+        if ( sym.get_simplify_algorithm() != dfl.get_simplify_algorithm() || explicit_defaults_ )
+        {
+            set_attr( node, "simplify-algorithm", sym.get_simplify_algorithm() );
+        }
+    }
+
     void add_metawriter_attributes(ptree &node, symbolizer_base const& sym)
     {
         if (!sym.get_metawriter_name().empty() || explicit_defaults_) {
@@ -774,6 +795,12 @@ void serialize_map(ptree & pt, Map const & map, bool explicit_defaults)
         set_attr( map_node, "buffer_size", buffer_size ); 
     }
 
+    label_detector_e label_detector = map.label_detector();
+    if ( label_detector != QUAD_TREE_DETECTOR || explicit_defaults)
+    {
+        set_attr( map_node, "label_detector", label_detector );
+    }
+
     {
         Map::const_fontset_iterator it = map.fontsets().begin();
         Map::const_fontset_iterator end = map.fontsets().end();
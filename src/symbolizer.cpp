@@ -24,9 +24,18 @@
 //mapnik
 #include <mapnik/symbolizer.hpp>
 #include <mapnik/map.hpp>
+#include <mapnik/vertex_filter.hpp>
 
 namespace mapnik {
 
+static const char * simplify_algorithm_strings[] = {
+    "radial-distance",
+    "douglas-peucker",
+    ""
+};
+
+IMPLEMENT_ENUM( simplify_algorithm_e, simplify_algorithm_strings );
+
 void symbolizer_base::add_metawriter(std::string const& name, metawriter_properties const& properties)
 {
     writer_name_ = name;
@@ -148,6 +148,7 @@ text_symbolizer::text_symbolizer(text_symbolizer const& rhs)
     : symbolizer_base(rhs),
       name_(rhs.name_),
       orientation_(rhs.orientation_),
+      priority_(rhs.priority_),
       face_name_(rhs.face_name_),
       fontset_(rhs.fontset_),
       size_(rhs.size_),
@@ -182,6 +183,7 @@ text_symbolizer& text_symbolizer::operator=(text_symbolizer const& other)
         return *this;
     name_ = other.name_;
     orientation_ = other.orientation_;
+    priority_ = other.priority_;
     face_name_ = other.face_name_;
     fontset_ = other.fontset_;
     size_ = other.size_;
@@ -233,6 +235,16 @@ void text_symbolizer::set_orientation(expression_ptr orientation)
     orientation_ = orientation;
 }
 
+expression_ptr text_symbolizer::get_priority() const
+{
+    return priority_;
+}
+
+void text_symbolizer::set_priority(expression_ptr priority)
+{
+    priority_ = priority;
+}
+
 std::string const&  text_symbolizer::get_face_name() const
 {
     return face_name_;
@@ -0,0 +1,188 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/well_known_srs.hpp>
+// boost
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+// stl
+#include <map>
+#include <vector>
+
+namespace mapnik {
+
+namespace {
+
+typedef std::map<std::string,std::string> proj_params;
+
+// "+proj=merc +a=6378137 +no_defs" -> {proj:merc, a:6378137, no_defs:""}
+bool parse_params(std::string const& srs, proj_params & params)
+{
+    std::vector<std::string> tokens;
+    std::string trimmed = boost::algorithm::trim_copy(srs);
+    boost::algorithm::split(tokens, trimmed, boost::algorithm::is_space(),
+                            boost::algorithm::token_compress_on);
+    for (std::vector<std::string>::const_iterator itr = tokens.begin();
+         itr != tokens.end(); ++itr)
+    {
+        std::string token = *itr;
+        if (token.empty()) continue;
+        if (token[0] == '+') token.erase(0,1);
+        std::string::size_type pos = token.find('=');
+        std::string key = boost::algorithm::to_lower_copy(token.substr(0,pos));
+        std::string value = pos == std::string::npos ? "" : token.substr(pos + 1);
+        if (key.empty() || params.count(key)) return false;
+        params[key] = value;
+    }
+    return !params.empty();
+}
+
+bool equals(std::string const& value, double expected)
+{
+    try
+    {
+        return boost::lexical_cast<double>(value) == expected;
+    }
+    catch (boost::bad_lexical_cast const&)
+    {
+        return false;
+    }
+}
+
+bool is_zero_towgs84(std::string const& value)
+{
+    std::vector<std::string> parts;
+    boost::algorithm::split(parts, value, boost::algorithm::is_any_of(","));
+    for (unsigned i = 0; i < parts.size(); ++i)
+    {
+        if (!equals(parts[i], 0.0)) return false;
+    }
+    return true;
+}
+
+bool is_wgs84(proj_params const& params)
+{
+    bool has_proj = false;
+    bool has_datum = false;
+    for (proj_params::const_iterator itr = params.begin(); itr != params.end(); ++itr)
+    {
+        std::string const& key = itr->first;
+        std::string const& value = itr->second;
+        if (key == "init")
+        {
+            if (!boost::algorithm::iequals(value, "epsg:4326")) return false;
+            has_proj = has_datum = true;
+        }
+        else if (key == "proj")
+        {
+            if (value != "longlat" && value != "latlong" && value != "lonlat" && value != "latlon")
+                return false;
+            has_proj = true;
+        }
+        else if (key == "datum" || key == "ellps")
+        {
+            if (value != "WGS84") return false;
+            has_datum = true;
+        }
+        else if (key == "towgs84")
+        {
+            if (!is_zero_towgs84(value)) return false;
+        }
+        else if (key != "no_defs" && key != "wktext")
+        {
+            return false;
+        }
+    }
+    return has_proj && has_datum;
+}
+
+// the sphere based mercator used by google, bing, osm (epsg:900913/3857)
+bool is_spherical_mercator(proj_params const& params, bool & over)
+{
+    bool has_a = false;
+    bool has_b = false;
+    bool has_nadgrids = false;
+    over = false;
+    for (proj_params::const_iterator itr = params.begin(); itr != params.end(); ++itr)
+    {
+        std::string const& key = itr->first;
+        std::string const& value = itr->second;
+        if (key == "proj")
+        {
+            if (value != "merc") return false;
+        }
+        else if (key == "a" || key == "b")
+        {
+            if (!equals(value, merc_detail::EARTH_RADIUS)) return false;
+            (key == "a" ? has_a : has_b) = true;
+        }
+        else if (key == "nadgrids")
+        {
+            if (value != "@null") return false;
+            has_nadgrids = true;
+        }
+        else if (key == "lat_ts" || key == "lon_0" || key == "x_0" || key == "y_0")
+        {
+            if (!equals(value, 0.0)) return false;
+        }
+        else if (key == "k" || key == "k_0")
+        {
+            if (!equals(value, 1.0)) return false;
+        }
+        else if (key == "units")
+        {
+            if (value != "m") return false;
+        }
+        else if (key == "over")
+        {
+            over = true;
+        }
+        else if (key != "no_defs" && key != "wktext")
+        {
+            return false;
+        }
+    }
+    return params.count("proj") && has_a && has_b && has_nadgrids;
+}
+}
+
+boost::optional<well_known_srs_e> is_well_known_srs(std::string const& srs)
+{
+    boost::optional<well_known_srs_e> result;
+    proj_params params;
+    if (!parse_params(srs, params)) return result;
+    bool over = false;
+    if (is_wgs84(params))
+    {
+        result.reset(WGS_84);
+    }
+    else if (is_spherical_mercator(params, over))
+    {
+        result.reset(over ? G_MERC_OVER : G_MERC);
+    }
+    return result;
+}
+
+}
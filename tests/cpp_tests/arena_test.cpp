@@ -0,0 +1,55 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/shared_ptr.hpp>
+#include <mapnik/arena.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/geometry.hpp>
+
+
+//  --------------------------------------------------------------------------//
+
+int main( int, char*[] )
+{
+  using mapnik::arena;
+  using mapnik::arena_scope;
+
+  arena a;
+  BOOST_TEST(arena::current() == 0);
+  {
+      arena_scope scope(&a);
+      BOOST_TEST(arena::current() == &a);
+
+      boost::shared_ptr<mapnik::Feature> feature(mapnik::feature_factory::create(1));
+      feature->put("name", UnicodeString("x"));
+      feature->put("lanes", 2);
+      mapnik::geometry2d * line = new mapnik::line_string_impl;
+      for (unsigned i = 0; i < 1000; ++i)
+      {
+          line->line_to(i, i * 2);
+      }
+      feature->add_geometry(line);
+      BOOST_TEST(a.used() > 1000 * 2 * sizeof(double));
+
+      double x = 0, y = 0;
+      feature->get_geometry(0).get_vertex(999, &x, &y);
+      BOOST_TEST_EQ(x, 999.0);
+      BOOST_TEST_EQ(y, 1998.0);
+      BOOST_TEST_EQ((*feature)["lanes"].to_int(), 2);
+
+      // nested scopes restore the enclosing arena
+      {
+          arena_scope heap(0);
+          BOOST_TEST(arena::current() == 0);
+          boost::shared_ptr<mapnik::Feature> other(mapnik::feature_factory::create(2));
+          other->put("lanes", 3);
+      }
+      BOOST_TEST(arena::current() == &a);
+  }
+  BOOST_TEST(arena::current() == 0);
+
+  a.release();
+  BOOST_TEST_EQ(a.used(), 0u);
+
+  return ::boost::report_errors();
+}
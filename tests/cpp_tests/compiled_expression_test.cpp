@@ -0,0 +1,65 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/filter_factory.hpp>
+#include <mapnik/expression_evaluator.hpp>
+#include <mapnik/compiled_expression.hpp>
+
+
+//  --------------------------------------------------------------------------//
+
+int main( int, char*[] )
+{
+  using mapnik::Feature;
+  using mapnik::value_type;
+
+  const char * expressions[] = {
+      "[pop] > 1000",
+      "[pop] + 1 = 1001 or [name] = 'Berlin'",
+      "[pop] < 10 and [name].match('.*in')",
+      "not ([kind] = 'city') and [pop] >= 100",
+      "[name].replace('e','a')",
+      "([pop] % 7) * 2.5 - [area] / 2",
+      "[missing] = 1 or [missing] != 1",
+      "1 + 2 * 3 != 7",
+      "[kind] = 'town' or [kind] = 'village' or [kind] = 'city'",
+      "[pop] > 10 and ([area] < 100 or not [name] = 'Bern')"
+  };
+  const unsigned num_expressions = sizeof(expressions) / sizeof(expressions[0]);
+
+  mapnik::context_ptr ctx(new mapnik::context);
+  const char * names[] = { "Berlin", "Bern", "Eberswalde", "" };
+  const char * kinds[] = { "city", "town", "village" };
+
+  for (unsigned e = 0; e < num_expressions; ++e)
+  {
+      mapnik::expression_ptr expr = mapnik::parse_expression(expressions[e], "utf-8");
+      mapnik::compiled_expression compiled(expr);
+
+      for (int i = 0; i < 24; ++i)
+      {
+          boost::scoped_ptr<Feature> feature(mapnik::feature_factory::create(ctx, i));
+          feature->put("pop", i * 250);
+          feature->put("area", i * 12.5);
+          feature->put("name", UnicodeString(names[i % 4]));
+          if (i % 5) feature->put("kind", UnicodeString(kinds[i % 3]));
+
+          value_type expected = boost::apply_visitor(mapnik::evaluate<Feature,value_type>(*feature), *expr);
+          value_type result = compiled.evaluate(*feature);
+          BOOST_TEST( result.to_string() == expected.to_string() );
+          BOOST_TEST( result.to_bool() == expected.to_bool() );
+      }
+
+      // features with their own context rebind the expression
+      Feature feature(1);
+      feature.put("name", UnicodeString("Berlin"));
+      feature.put("pop", 999);
+      value_type expected = boost::apply_visitor(mapnik::evaluate<Feature,value_type>(feature), *expr);
+      BOOST_TEST( compiled.evaluate(feature).to_string() == expected.to_string() );
+  }
+
+  return ::boost::report_errors();
+}
@@ -0,0 +1,92 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <vector>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/filter_factory.hpp>
+#include <mapnik/expression_evaluator.hpp>
+#include <mapnik/filter_dispatch.hpp>
+
+
+//  --------------------------------------------------------------------------//
+
+int main( int, char*[] )
+{
+  using mapnik::Feature;
+  using mapnik::value_type;
+  using mapnik::filter_dispatch;
+
+  const char * rules[] = {
+      "[highway] = 'motorway'",
+      "[highway] = 'primary'",
+      "[lanes] > 2",
+      "'secondary' = [highway]",
+      "[highway] = 'primary'",
+      "[highway] = 3",
+      "[highway] = 'residential' or [lanes] = 1",
+      "[kind] = 'x'",
+      "[highway] = 'service'"
+  };
+  const unsigned num_rules = sizeof(rules) / sizeof(rules[0]);
+
+  std::vector<mapnik::expression_ptr> filters;
+  for (unsigned i = 0; i < num_rules; ++i)
+  {
+      filters.push_back(mapnik::parse_expression(rules[i], "utf-8"));
+  }
+
+  filter_dispatch dispatch(filters);
+  BOOST_TEST( dispatch.enabled() );
+  BOOST_TEST( dispatch.attribute_name() == "highway" );
+
+  mapnik::context_ptr ctx(new mapnik::context);
+  std::vector<value_type> highways;
+  highways.push_back(UnicodeString("motorway"));
+  highways.push_back(UnicodeString("primary"));
+  highways.push_back(UnicodeString("secondary"));
+  highways.push_back(UnicodeString("residential"));
+  highways.push_back(UnicodeString("track"));
+  highways.push_back(3);
+  highways.push_back(3.0);
+  highways.push_back(true);
+  highways.push_back(value_type());
+
+  for (unsigned h = 0; h < highways.size(); ++h)
+  {
+      for (int lanes = 0; lanes < 4; ++lanes)
+      {
+          boost::scoped_ptr<Feature> feature(mapnik::feature_factory::create(ctx, h));
+          if (!highways[h].is_null()) feature->put("highway", highways[h]);
+          feature->put("lanes", lanes);
+
+          // the candidates must yield exactly the matching rules, in order
+          std::vector<unsigned> expected;
+          for (unsigned i = 0; i < num_rules; ++i)
+          {
+              if (boost::apply_visitor(mapnik::evaluate<Feature,value_type>(*feature), *filters[i]).to_bool())
+                  expected.push_back(i);
+          }
+          std::vector<unsigned> result;
+          filter_dispatch::candidates const& candidates = dispatch.lookup(*feature);
+          for (unsigned i = 0; i < candidates.size(); ++i)
+          {
+              if (i > 0) BOOST_TEST( candidates[i - 1].rule < candidates[i].rule );
+              if (candidates[i].matched ||
+                  boost::apply_visitor(mapnik::evaluate<Feature,value_type>(*feature), *filters[candidates[i].rule]).to_bool())
+                  result.push_back(candidates[i].rule);
+          }
+          BOOST_TEST( result == expected );
+      }
+  }
+
+  // too few comparisons of one attribute: every rule is a candidate
+  std::vector<mapnik::expression_ptr> few(filters.begin(), filters.begin() + 3);
+  filter_dispatch linear(few);
+  BOOST_TEST( !linear.enabled() );
+  Feature feature(1);
+  BOOST_TEST( linear.lookup(feature).size() == 3 );
+
+  return ::boost::report_errors();
+}
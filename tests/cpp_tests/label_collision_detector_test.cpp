@@ -0,0 +1,97 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <mapnik/label_collision_detector.hpp>
+#include <mapnik/wall_clock_timer.hpp>
+
+// places a dense layer of labels and returns how many were accepted,
+// recording every decision so both detectors can be compared
+template <typename Detector>
+unsigned place_labels(Detector & detector, std::vector<bool> & decisions, unsigned runs)
+{
+    const char * names[] = { "Main Street", "High Street", "Station Road", "Church Lane", "" };
+    unsigned placed = 0;
+    for (unsigned run = 0; run < runs; ++run)
+    {
+        detector.clear();
+        std::srand(42);
+        for (unsigned i = 0; i < 20000; ++i)
+        {
+            // within the extent, the quad tree misses labels beyond it
+            double x = std::rand() % 980 - 30;
+            double y = std::rand() % 1030 - 30;
+            double w = 10 + std::rand() % 80;
+            double h = 5 + std::rand() % 15;
+            mapnik::box2d<double> box(x, y, x + w, y + h);
+            UnicodeString text(names[i % 5]);
+            bool ok;
+            switch (i % 3)
+            {
+            case 0:
+                ok = detector.has_placement(box);
+                if (ok) detector.insert(box);
+                break;
+            case 1:
+                ok = detector.has_placement(box, text, 30.0);
+                if (ok) detector.insert(box, text);
+                break;
+            default:
+                ok = detector.has_point_placement(box, 5.0);
+                if (ok) detector.insert(box);
+                break;
+            }
+            if (run == 0) decisions.push_back(ok);
+            if (ok) ++placed;
+        }
+    }
+    return placed;
+}
+
+//  --------------------------------------------------------------------------//
+
+int main( int, char*[] )
+{
+  mapnik::box2d<double> extent(-32, -32, 1056, 1056);
+  const unsigned runs = 5;
+
+  mapnik::label_collision_detector4 quad_tree(extent);
+  mapnik::label_collision_detector4 grid(extent, mapnik::GRID_DETECTOR);
+
+  std::vector<bool> quad_tree_decisions;
+  std::vector<bool> grid_decisions;
+
+  mapnik::wall_clock_timer timer;
+  unsigned quad_tree_placed = place_labels(quad_tree, quad_tree_decisions, runs);
+  double quad_tree_ms = timer.elapsed();
+
+  timer.restart();
+  unsigned grid_placed = place_labels(grid, grid_decisions, runs);
+  double grid_ms = timer.elapsed();
+
+  BOOST_TEST(quad_tree_placed > 0);
+  BOOST_TEST_EQ(quad_tree_placed, grid_placed);
+  BOOST_TEST(quad_tree_decisions == grid_decisions);
+
+  // labels beyond the extent still collide on the grid
+  grid.clear();
+  grid.insert(mapnik::box2d<double>(-500, -500, -400, -400));
+  BOOST_TEST(!grid.has_placement(mapnik::box2d<double>(-450, -450, -300, -300)));
+  BOOST_TEST(grid.has_placement(mapnik::box2d<double>(-350, -350, -300, -300)));
+
+  // clear() forgets labels in every cell they were inserted into
+  grid.clear();
+  grid.insert(mapnik::box2d<double>(10, 10, 700, 300));
+  grid.clear();
+  BOOST_TEST(grid.has_placement(mapnik::box2d<double>(600, 200, 650, 250)));
+  grid.insert(mapnik::box2d<double>(600, 200, 650, 250));
+  BOOST_TEST(!grid.has_placement(mapnik::box2d<double>(640, 240, 660, 260)));
+  BOOST_TEST(grid.has_placement(mapnik::box2d<double>(10, 10, 50, 50)));
+
+  std::clog << "label collision detector, " << runs << " x 20000 labels: quad tree "
+            << quad_tree_ms << " ms, grid " << grid_ms << " ms\n";
+
+  return ::boost::report_errors();
+}
@@ -0,0 +1,114 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/format.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/filter_factory.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+#include <mapnik/graphics.hpp>
+#include <mapnik/agg_renderer.hpp>
+
+namespace {
+
+struct label
+{
+    int id;
+    double x;
+    double y;
+    int priority;
+};
+
+// one layer whose features are labelled in the order given, red for
+// priority 1, blue for 2, green for 3
+mapnik::Map make_map(label const* labels, unsigned count)
+{
+    std::string const srs("+proj=longlat +ellps=WGS84 +datum=WGS84 +no_defs");
+    mapnik::Map m(256, 256, srs);
+    mapnik::feature_type_style style;
+    const mapnik::color fills[] = { mapnik::color(255,0,0), mapnik::color(0,0,255), mapnik::color(0,255,0) };
+    for (int priority = 1; priority <= 3; ++priority)
+    {
+        mapnik::text_symbolizer text(mapnik::parse_expression("'XXXXXXXX'"), "DejaVu Sans Book",
+                                     14, fills[priority - 1]);
+        text.set_priority(mapnik::parse_expression("[priority]"));
+        mapnik::rule_type rule;
+        rule.set_filter(mapnik::parse_expression((boost::format("[priority] = %d") % priority).str()));
+        rule.append(text);
+        style.add_rule(rule);
+    }
+    m.insert_style("labels", style);
+
+    boost::shared_ptr<mapnik::memory_datasource> ds(new mapnik::memory_datasource);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        mapnik::feature_ptr feature(mapnik::feature_factory::create(labels[i].id));
+        mapnik::geometry2d * pt = new mapnik::point_impl;
+        pt->move_to(labels[i].x, labels[i].y);
+        feature->add_geometry(pt);
+        feature->put("priority", labels[i].priority);
+        ds->push(feature);
+    }
+    mapnik::layer lay("labels", srs);
+    lay.set_datasource(ds);
+    lay.add_style("labels");
+    m.addLayer(lay);
+    m.zoom_to_box(mapnik::box2d<double>(-10, -10, 10, 10));
+    return m;
+}
+
+// pixels of the image the given channel was drawn into
+unsigned count_pixels(mapnik::image_32 & image, unsigned shift)
+{
+    unsigned count = 0;
+    for (unsigned y = 0; y < image.height(); ++y)
+    {
+        for (unsigned x = 0; x < image.width(); ++x)
+        {
+            if ((image.data()(x,y) >> shift) & 0xff) ++count;
+        }
+    }
+    return count;
+}
+
+}
+
+//  --------------------------------------------------------------------------//
+
+int main( int, char*[] )
+{
+  BOOST_TEST(mapnik::freetype_engine::register_font("fonts/dejavu-fonts-ttf-2.30/ttf/DejaVuSans.ttf"));
+
+  const unsigned red = 0, green = 8, blue = 16;
+
+  // two labels on the same spot: the higher priority is drawn whichever
+  // feature comes first, the other one is culled and never drawn
+  const label low_first[] = { { 1, 0, 0, 1 }, { 2, 0, 0, 2 } };
+  const label high_first[] = { { 1, 0, 0, 2 }, { 2, 0, 0, 1 } };
+  const label* orders[] = { low_first, high_first };
+  for (unsigned i = 0; i < 2; ++i)
+  {
+      mapnik::Map m = make_map(orders[i], 2);
+      mapnik::image_32 image(m.width(), m.height());
+      mapnik::agg_renderer<mapnik::image_32> ren(m, image);
+      ren.apply();
+      BOOST_TEST(count_pixels(image, blue) > 0);
+      BOOST_TEST_EQ(count_pixels(image, red), 0u);
+  }
+
+  // labels clear of higher priority ones are drawn whatever their own
+  // priority, only the one under the highest is culled
+  const label three[] = { { 1, 0, 0, 1 }, { 2, 0, 0, 3 }, { 3, 0, -6, 2 }, { 4, 0, 6, 2 } };
+  mapnik::Map m = make_map(three, 4);
+  mapnik::image_32 image(m.width(), m.height());
+  mapnik::agg_renderer<mapnik::image_32> ren(m, image);
+  ren.apply();
+  BOOST_TEST(count_pixels(image, green) > 0);
+  BOOST_TEST(count_pixels(image, blue) > 0);
+  BOOST_TEST_EQ(count_pixels(image, red), 0u);
+
+  return ::boost::report_errors();
+}
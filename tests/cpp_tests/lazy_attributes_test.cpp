@@ -0,0 +1,73 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <cstdlib>
+#include <mapnik/feature_factory.hpp>
+
+// decodes the integer found at offset 4 * index of the record
+struct int_attributes : public mapnik::lazy_attributes
+{
+    int_attributes() : decoded(0) {}
+
+    void decode(std::size_t index, const char* record, mapnik::value & v) const
+    {
+        ++decoded;
+        v = std::atoi(std::string(record + 4 * index, 4).c_str());
+    }
+
+    mutable int decoded;
+};
+
+//  --------------------------------------------------------------------------//
+
+int main( int, char*[] )
+{
+  using mapnik::Feature;
+
+  const char record[] = "  10  20  30";
+  mapnik::context_ptr ctx(new mapnik::context);
+  ctx->push("a");
+  ctx->push("b");
+  ctx->push("c");
+  int_attributes * decoder = new int_attributes;
+  mapnik::lazy_attributes_ptr lazy(decoder);
+
+  boost::scoped_ptr<Feature> feature(mapnik::feature_factory::create(ctx, 1));
+  Feature const& reader = *feature;
+  feature->set_lazy_attributes(lazy, record, 1 | 4);
+  feature->put("b", 2);
+  BOOST_TEST_EQ( decoder->decoded, 0 );
+
+  // decoded once on first read
+  BOOST_TEST_EQ( reader["c"].to_int(), 30 );
+  BOOST_TEST_EQ( reader["c"].to_int(), 30 );
+  BOOST_TEST_EQ( decoder->decoded, 1 );
+  BOOST_TEST_EQ( reader["b"].to_int(), 2 );
+
+  // assigning a lazy attribute replaces it without decoding it
+  (*feature)["a"] = 5;
+  BOOST_TEST_EQ( reader["a"].to_int(), 5 );
+  BOOST_TEST_EQ( decoder->decoded, 1 );
+  BOOST_TEST_EQ( feature->size(), 3u );
+  BOOST_TEST_EQ( decoder->decoded, 1 );
+
+  // erased or put attributes are not decoded anymore
+  boost::scoped_ptr<Feature> other(mapnik::feature_factory::create(ctx, 2));
+  other->set_lazy_attributes(lazy, record, 1 | 2 | 4);
+  other->erase("a");
+  other->put("c", 3);
+  BOOST_TEST( !other->has_key("a") );
+  BOOST_TEST_EQ( other->size(), 2u );
+  BOOST_TEST_EQ( decoder->decoded, 2 );
+  BOOST_TEST_EQ( (*other)["c"].to_int(), 3 );
+
+  // copies share the decoder but decode on their own
+  boost::scoped_ptr<Feature> copy(mapnik::feature_factory::create(ctx, 1));
+  copy->copy_attributes(*feature);
+  BOOST_TEST_EQ( copy->size(), 3u );
+  BOOST_TEST_EQ( decoder->decoded, 2 );
+
+  return ::boost::report_errors();
+}
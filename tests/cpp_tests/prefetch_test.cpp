@@ -0,0 +1,161 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <iostream>
+#include <cstdlib>
+#include <map>
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/feature_style_processor.hpp>
+
+namespace {
+
+boost::mutex mutex;
+int errors = 0;
+
+// fails if a query is issued while features of another are still read
+class serial_datasource : public mapnik::memory_datasource
+{
+public:
+    serial_datasource()
+        : open_(false) {}
+
+    mapnik::featureset_ptr features(mapnik::query const& q) const
+    {
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            if (open_) ++errors;
+            open_ = true;
+        }
+        // leaves the other workers time to run into this datasource
+        boost::this_thread::sleep(boost::posix_time::milliseconds(5));
+        return mapnik::featureset_ptr(new guard(memory_datasource::features(q), open_));
+    }
+
+private:
+    struct guard : public mapnik::Featureset
+    {
+        guard(mapnik::featureset_ptr const& fs, bool & open)
+            : fs_(fs),
+              open_(open) {}
+
+        ~guard()
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            open_ = false;
+        }
+
+        mapnik::feature_ptr next()
+        {
+            return fs_->next();
+        }
+
+        mapnik::featureset_ptr fs_;
+        bool & open_;
+    };
+
+    mutable bool open_;
+};
+
+// counts the features symbolized per layer
+class counting_processor : public mapnik::feature_style_processor<counting_processor>
+{
+public:
+    explicit counting_processor(mapnik::Map const& m)
+        : mapnik::feature_style_processor<counting_processor>(m),
+          layer_(0) {}
+
+    void start_map_processing(mapnik::Map const&) {}
+    void end_map_processing(mapnik::Map const&) {}
+
+    void start_layer_processing(mapnik::layer const& lay)
+    {
+        layer_ = &lay;
+    }
+
+    void end_layer_processing(mapnik::layer const&) {}
+
+    template <typename Symbolizer>
+    void process(Symbolizer const&, mapnik::Feature const&, mapnik::proj_transform const&)
+    {
+        ++counts[layer_->name()];
+    }
+
+    std::map<std::string,int> counts;
+
+private:
+    mapnik::layer const* layer_;
+};
+
+void watchdog()
+{
+    boost::this_thread::sleep(boost::posix_time::seconds(30));
+    std::cerr << "prefetch_test: rendering did not finish\n";
+    std::abort();
+}
+
+}
+
+//  --------------------------------------------------------------------------//
+
+int main( int, char*[] )
+{
+  std::string const srs("+proj=longlat +ellps=WGS84 +datum=WGS84 +no_defs");
+  mapnik::Map m(256, 256, srs);
+  mapnik::feature_type_style style;
+  mapnik::rule_type rule;
+  rule.append(mapnik::point_symbolizer());
+  style.add_rule(rule);
+  m.insert_style("points", style);
+
+  // more datasources than prefetch threads and layers on the same
+  // datasource interleaved: L1(A) L2(B) L3(C) L4(A) L5(B) L6(A) L7(B).
+  // Workers waiting for L4 and L5 to be rendered before fetching L6 and
+  // L7 would leave nobody to fetch L3
+  boost::shared_ptr<serial_datasource> ds[3];
+  for (unsigned i = 0; i < 3; ++i)
+  {
+      ds[i].reset(new serial_datasource);
+      for (int id = 0; id < 10; ++id)
+      {
+          mapnik::feature_ptr feature(mapnik::feature_factory::create(id));
+          mapnik::geometry2d * pt = new mapnik::point_impl;
+          pt->move_to(id, i);
+          feature->add_geometry(pt);
+          ds[i]->push(feature);
+      }
+  }
+  const char* names[] = { "L1", "L2", "L3", "L4", "L5", "L6", "L7" };
+  const unsigned chains[] = { 0, 1, 2, 0, 1, 0, 1 };
+  for (unsigned i = 0; i < 7; ++i)
+  {
+      mapnik::layer lay(names[i], srs);
+      lay.set_datasource(ds[chains[i]]);
+      lay.add_style("points");
+      m.addLayer(lay);
+  }
+  m.zoom_to_box(mapnik::box2d<double>(-1, -1, 11, 11));
+
+  boost::thread guard(watchdog);
+  for (unsigned threads = 2; threads <= 3; ++threads)
+  {
+      for (unsigned run = 0; run < 20; ++run)
+      {
+          counting_processor p(m);
+          p.set_prefetch_threads(threads);
+          p.apply();
+          for (unsigned i = 0; i < 7; ++i)
+          {
+              BOOST_TEST_EQ(p.counts[names[i]], 10);
+          }
+      }
+  }
+  BOOST_TEST_EQ(errors, 0);
+
+  return ::boost::report_errors();
+}
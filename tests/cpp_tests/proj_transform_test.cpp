@@ -0,0 +1,123 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+#include <mapnik/well_known_srs.hpp>
+
+
+//  --------------------------------------------------------------------------//
+
+int main( int, char*[] )
+{
+  std::string wgs84_srs("+proj=longlat +ellps=WGS84 +datum=WGS84 +no_defs");
+  std::string merc_srs("+proj=merc +a=6378137 +b=6378137 +lat_ts=0.0 +lon_0=0.0 +x_0=0.0 +y_0=0 +k=1.0 +units=m +nadgrids=@null +wktext +no_defs +over");
+
+//  well known srs detection  -----------------------------------------------//
+
+  BOOST_TEST( mapnik::is_well_known_srs(wgs84_srs) );
+  BOOST_TEST( *mapnik::is_well_known_srs(wgs84_srs) == mapnik::WGS_84 );
+  BOOST_TEST( *mapnik::is_well_known_srs("+init=epsg:4326") == mapnik::WGS_84 );
+  BOOST_TEST( *mapnik::is_well_known_srs(merc_srs) == mapnik::G_MERC_OVER );
+  BOOST_TEST( *mapnik::is_well_known_srs("+proj=merc +a=6378137 +b=6378137 +nadgrids=@null") == mapnik::G_MERC );
+  BOOST_TEST( !mapnik::is_well_known_srs("+proj=merc +ellps=WGS84 +datum=WGS84") );
+  BOOST_TEST( !mapnik::is_well_known_srs("+proj=merc +a=6378137 +b=6378137 +lon_0=10 +nadgrids=@null") );
+  BOOST_TEST( !mapnik::is_well_known_srs("+proj=longlat +ellps=intl") );
+  BOOST_TEST( !mapnik::is_well_known_srs("+proj=longlat +datum=WGS84 +pm=paris") );
+  BOOST_TEST( !mapnik::is_well_known_srs("") );
+
+//  fast path matches proj  -------------------------------------------------//
+
+  mapnik::projection wgs84(wgs84_srs);
+  mapnik::projection merc(merc_srs);
+  mapnik::projection merc_wrapped("+proj=merc +a=6378137 +b=6378137 +nadgrids=@null +no_defs");
+  mapnik::proj_transform tr(wgs84, merc);
+  mapnik::proj_transform tr_wrapped(wgs84, merc_wrapped);
+  mapnik::proj_transform tr_inverse(merc, wgs84);
+
+  std::vector<double> xs;
+  std::vector<double> ys;
+  for (double lon = -200.0; lon <= 200.0; lon += 12.5)
+  {
+      for (double lat = -89.0; lat <= 89.0; lat += 7.25)
+      {
+          xs.push_back(lon);
+          ys.push_back(lat);
+      }
+  }
+
+  for (unsigned i = 0; i < xs.size(); ++i)
+  {
+      // reference: plain pj_fwd, no datum shift involved for these
+      double ref_x = xs[i];
+      double ref_y = ys[i];
+      merc.forward(ref_x, ref_y);
+
+      double x = xs[i];
+      double y = ys[i];
+      double z = 0;
+      BOOST_TEST( tr.forward(x, y, z) );
+      BOOST_TEST( std::fabs(x - ref_x) < 1e-6 );
+      BOOST_TEST( std::fabs(y - ref_y) < 1e-6 );
+
+      double wx = xs[i];
+      double wy = ys[i];
+      double wref_x = xs[i];
+      double wref_y = ys[i];
+      merc_wrapped.forward(wref_x, wref_y);
+      BOOST_TEST( tr_wrapped.forward(wx, wy, z) );
+      BOOST_TEST( std::fabs(wx - wref_x) < 1e-6 );
+      BOOST_TEST( std::fabs(wy - wref_y) < 1e-6 );
+
+      // round trip in both directions
+      BOOST_TEST( tr.backward(x, y, z) );
+      BOOST_TEST( std::fabs(x - xs[i]) < 1e-9 );
+      BOOST_TEST( std::fabs(y - ys[i]) < 1e-9 );
+      BOOST_TEST( tr_inverse.backward(x, y, z) );
+      BOOST_TEST( tr_inverse.forward(x, y, z) );
+      BOOST_TEST( std::fabs(x - xs[i]) < 1e-9 );
+      BOOST_TEST( std::fabs(y - ys[i]) < 1e-9 );
+  }
+
+//  poles can't be projected  -----------------------------------------------//
+
+  {
+      double x = 0;
+      double y = 90;
+      double z = 0;
+      BOOST_TEST( !tr.forward(x, y, z) );
+      BOOST_TEST( x == HUGE_VAL && y == HUGE_VAL );
+  }
+
+//  batched, interleaved coordinates  ---------------------------------------//
+
+  {
+      std::vector<double> coords;
+      for (unsigned i = 0; i < xs.size(); ++i)
+      {
+          coords.push_back(xs[i]);
+          coords.push_back(ys[i]);
+      }
+      BOOST_TEST( tr.forward(&coords[0], &coords[1], 0, xs.size(), 2) );
+      for (unsigned i = 0; i < xs.size(); ++i)
+      {
+          double x = xs[i];
+          double y = ys[i];
+          double z = 0;
+          tr.forward(x, y, z);
+          BOOST_TEST( coords[2 * i] == x );
+          BOOST_TEST( coords[2 * i + 1] == y );
+      }
+      BOOST_TEST( tr.backward(&coords[0], &coords[1], 0, xs.size(), 2) );
+      for (unsigned i = 0; i < xs.size(); ++i)
+      {
+          BOOST_TEST( std::fabs(coords[2 * i] - xs[i]) < 1e-9 );
+          BOOST_TEST( std::fabs(coords[2 * i + 1] - ys[i]) < 1e-9 );
+      }
+  }
+
+  return ::boost::report_errors();
+}
@@ -0,0 +1,87 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <vector>
+#include <mapnik/vertex_filter.hpp>
+
+// replays a list of vertices like an agg vertex source
+struct vertex_list
+{
+    struct item
+    {
+        double x, y;
+        unsigned cmd;
+    };
+
+    void add(double x, double y, unsigned cmd)
+    {
+        item v = { x, y, cmd };
+        vertices.push_back(v);
+    }
+
+    void rewind(unsigned) { pos = 0; }
+
+    unsigned vertex(double * x, double * y)
+    {
+        if (pos >= vertices.size()) return mapnik::SEG_END;
+        *x = vertices[pos].x;
+        *y = vertices[pos].y;
+        return vertices[pos++].cmd;
+    }
+
+    std::vector<item> vertices;
+    std::size_t pos;
+};
+
+template <typename Filter>
+std::vector<double> read_xs(Filter & filter)
+{
+    std::vector<double> xs;
+    double x, y;
+    filter.rewind(0);
+    while (filter.vertex(&x,&y) != mapnik::SEG_END) xs.push_back(x);
+    return xs;
+}
+
+//  --------------------------------------------------------------------------//
+
+int main( int, char*[] )
+{
+  using mapnik::vertex_filter;
+  using mapnik::SEG_MOVETO;
+  using mapnik::SEG_LINETO;
+
+  // a line along x with a 0.1 pixel wobble, then a second line
+  vertex_list path;
+  path.add(0, 0, SEG_MOVETO);
+  path.add(0.2, 0.1, SEG_LINETO);
+  path.add(0.4, 0, SEG_LINETO);
+  path.add(5, 0.1, SEG_LINETO);
+  path.add(10, 0, SEG_LINETO);
+  path.add(20, 0, SEG_MOVETO);
+  path.add(20.1, 0, SEG_LINETO);
+
+  // no tolerance passes everything through
+  vertex_filter<vertex_list> none(path, 0.0);
+  BOOST_TEST_EQ( read_xs(none).size(), 7u );
+
+  // radial distance drops the close vertices but keeps sub path ends
+  vertex_filter<vertex_list> radial(path, 1.0);
+  std::vector<double> xs = read_xs(radial);
+  BOOST_TEST_EQ( xs.size(), 5u );
+  BOOST_TEST_EQ( xs[0], 0.0 );
+  BOOST_TEST_EQ( xs[1], 5.0 );
+  BOOST_TEST_EQ( xs[2], 10.0 );
+  BOOST_TEST_EQ( xs[3], 20.0 );
+  BOOST_TEST_EQ( xs[4], 20.1 );
+
+  // douglas-peucker keeps only the end points of the straight line
+  vertex_filter<vertex_list> dp(path, 0.5, mapnik::DOUGLAS_PEUCKER);
+  xs = read_xs(dp);
+  BOOST_TEST_EQ( xs.size(), 4u );
+  BOOST_TEST_EQ( xs[1], 10.0 );
+  // rewinding replays the simplified path
+  BOOST_TEST_EQ( read_xs(dp).size(), 4u );
+
+  return ::boost::report_errors();
+}
@@ -3,7 +3,10 @@
 from nose.tools import *
 from utilities import execution_path
 
-import os, mapnik2
+import tempfile
+import shutil
+
+import os, glob, mapnik2
 
 def setup():
     # All of the paths used are relative, if we run the tests
@@ -43,4 +46,45 @@ def test_feature_attributes():
     eq_(feat.attributes, attrs)
     eq_(lyr.datasource.fields(),['AREA', 'EAS_ID', 'PRFEDEA'])
     eq_(lyr.datasource.field_types(),[float,int,str])
-    
\ No newline at end of file
+    
+def render_world(shape_file, map_srs, box, **keywords):
+    m = mapnik2.Map(256, 256, map_srs)
+    s = mapnik2.Style()
+    r = mapnik2.Rule()
+    r.symbols.append(mapnik2.LineSymbolizer())
+    s.rules.append(r)
+    m.append_style('lines', s)
+    lyr = mapnik2.Layer('world', '+proj=merc +a=6378137 +b=6378137 +lat_ts=0.0 +lon_0=0.0 +x_0=0.0 +y_0=0 +k=1.0 +units=m +no_defs')
+    lyr.datasource = mapnik2.Shapefile(file=shape_file, **keywords)
+    lyr.styles.append('lines')
+    m.layers.append(lyr)
+    m.zoom_to_box(box)
+    i = mapnik2.Image(m.width, m.height)
+    mapnik2.render(m, i)
+    return i.tostring()
+
+def test_shapefile_generalized_in_reprojected_layer():
+    # the map is in millimetres, the layer in metres: the level has to
+    # be chosen by the resolution in layer units, or the coarsest level
+    # would be drawn 4 pixels off
+    map_srs = '+proj=merc +a=6378137 +b=6378137 +lat_ts=0.0 +lon_0=0.0 +x_0=0.0 +y_0=0 +k=1.0 +to_meter=0.001 +no_defs'
+    box = mapnik2.Box2d(-1e9, 4e9, 4e9, 9e9)
+    # the .generalized file is written next to the shapefile, so work on a
+    # copy rather than leaving it in the source tree
+    tmp_dir = tempfile.mkdtemp(prefix='mapnik-temp-shp-')
+    try:
+        for name in glob.glob('../data/shp/world_merc.*'):
+            shutil.copy(name, tmp_dir)
+        shape_file = os.path.join(tmp_dir, 'world_merc')
+        original = render_world(shape_file, map_srs, box)
+        generalized = render_world(shape_file, map_srs, box, generalize='true')
+    finally:
+        shutil.rmtree(tmp_dir)
+    drawn = changed = 0
+    for pos in xrange(0, len(original), 4):
+        if original[pos:pos+4] != '\x00\x00\x00\x00':
+            drawn += 1
+        if original[pos:pos+4] != generalized[pos:pos+4]:
+            changed += 1
+    ok_(drawn > 1000)
+    ok_(changed < drawn / 10, '%d of %d pixels changed' % (changed, drawn))
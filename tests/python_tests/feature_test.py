@@ -38,6 +38,19 @@ class FeatureTest(unittest.TestCase):
         for v in (1, True, 1.4, "foo", u"avión"):
             test_val(v)
 
+    def test_mapping_protocol(self):
+        f = self.makeOne(1)
+        f['b'] = 2
+        f['a'] = 1
+        self.failUnlessEqual(len(f), 2)
+        self.failUnless('a' in f)
+        self.failIf('c' in f)
+        self.failUnlessEqual(list(f.iteritems()), [('a', 1), ('b', 2)])
+        del f['a']
+        self.failUnlessEqual(len(f), 1)
+        self.failIf('a' in f)
+        self.failUnlessRaises(KeyError, lambda: f['a'])
+
 
     def test_add_wkb_geometry(self):
         try:
@@ -63,11 +63,15 @@ def test_polygonsymbolizer_init():
 def test_polygonsymbolizer_pickle():
     p = mapnik2.PolygonSymbolizer(mapnik2.Color('black'))
     p.fill_opacity = .5
+    p.simplify = 0.5
+    p.simplify_algorithm = mapnik2.simplify_algorithm.DOUGLAS_PEUCKER
     # does not work for some reason...
     #eq_(pickle.loads(pickle.dumps(p)), p)
     p2 = pickle.loads(pickle.dumps(p,pickle.HIGHEST_PROTOCOL))
     eq_(p.fill, p2.fill)
     eq_(p.fill_opacity, p2.fill_opacity)
+    eq_(p.simplify, p2.simplify)
+    eq_(p.simplify_algorithm, p2.simplify_algorithm)
 
 
 # Stroke initialization
@@ -147,7 +151,10 @@ def test_linesymbolizer_init():
 # LineSymbolizer pickling
 def test_linesymbolizer_pickle():
     p = mapnik2.LineSymbolizer()
+    p.simplify = 1.0
     p2 = pickle.loads(pickle.dumps(p,pickle.HIGHEST_PROTOCOL))
+    eq_(p.simplify, p2.simplify)
+    eq_(p.simplify_algorithm, p2.simplify_algorithm)
     # line and stroke eq fails, so we compare attributes for now..
     s,s2 = p.stroke, p2.stroke
     eq_(s.color, s2.color)
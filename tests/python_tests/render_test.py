@@ -45,6 +45,22 @@ def test_render_image_to_file():
     else:
         return False
 
+def test_render_metatile():
+    m = mapnik2.Map(256, 256)
+    m.background = mapnik2.Color('steelblue')
+    tiles = mapnik2.render_metatile(m, mapnik2.Box2d(-180, -180, 180, 180), 2, 256, 'png')
+    eq_(len(tiles), 4)
+
+    m.zoom_to_box(mapnik2.Box2d(0, -180, 180, 0))
+    i = mapnik2.Image(256, 256)
+    mapnik2.render(m, i)
+    eq_(tiles[3], i.tostring('png'))
+
+@raises(RuntimeError)
+def test_render_metatile_non_square_extent():
+    m = mapnik2.Map(256, 256)
+    mapnik2.render_metatile(m, mapnik2.Box2d(-180, -90, 180, 90), 2, 256, 'png')
+
 def get_paired_images(w,h,mapfile):
     tmp_map = 'tmp_map.xml'
     m = mapnik2.Map(w,h)
@@ -30,7 +30,9 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/program_options.hpp>
+#include <boost/thread/thread.hpp>
 #include "quadtree.hpp"
+#include "str_tree.hpp"
 #include "shapefile.hpp"
 #include "shape_io.hpp"
 
@@ -39,6 +41,7 @@ const int DEFAULT_DEPTH = 8;
 const double MINRATIO=0.5;
 const double MAXRATIO=0.8;
 const double DEFAULT_RATIO=0.55;
+const unsigned DEFAULT_NODE_SIZE=16;
 
 int main (int argc,char** argv) 
 {
@@ -52,6 +55,9 @@ int main (int argc,char** argv)
     bool verbose=false;
     unsigned int depth=DEFAULT_DEPTH;
     double ratio=DEFAULT_RATIO;
+    bool bulk_load=false;
+    unsigned node_size=DEFAULT_NODE_SIZE;
+    unsigned threads=boost::thread::hardware_concurrency();
     vector<string> shape_files;
     
     try
@@ -63,6 +69,9 @@ int main (int argc,char** argv)
             ("verbose,v","verbose output")
             ("depth,d", po::value<unsigned int>(), "max tree depth\n(default 8)")   
             ("ratio,r",po::value<double>(),"split ratio (default 0.55)")
+            ("str,s","bulk load a sort-tile-recursive tree instead of a quadtree,\nfaster and smaller on large files")
+            ("node-size,n",po::value<unsigned>(),"records per leaf with --str (default 16)")
+            ("threads,t",po::value<unsigned>(),"threads sorting with --str\n(default: number of cores)")
             ("shape_files",po::value<vector<string> >(),"shape files to index: file1 file2 ...fileN")
             ;
         
@@ -92,6 +101,19 @@ int main (int argc,char** argv)
             ratio = vm["ratio"].as<double>();
         }
         
+        if (vm.count("str"))
+        {
+            bulk_load = true;
+        }
+        if (vm.count("node-size"))
+        {
+            node_size = vm["node-size"].as<unsigned>();
+        }
+        if (vm.count("threads"))
+        {
+            threads = vm["threads"].as<unsigned>();
+        }
+        
         if (vm.count("shape_files"))
         {
             shape_files=vm["shape_files"].as< vector<string> >();
@@ -103,8 +125,16 @@ int main (int argc,char** argv)
         return -1;
     }
     
-    clog << "max tree depth:" << depth << endl;
-    clog << "split ratio:" << ratio << endl;
+    if (bulk_load)
+    {
+        clog << "node size:" << node_size << endl;
+        clog << "threads:" << threads << endl;
+    }
+    else
+    {
+        clog << "max tree depth:" << depth << endl;
+        clog << "split ratio:" << ratio << endl;
+    }
   
     vector<string>::const_iterator itr = shape_files.begin();
     if (itr == shape_files.end())
@@ -151,6 +181,16 @@ int main (int argc,char** argv)
         int pos=50;
         shp.seek(pos*2);  
         quadtree<int> tree(extent,depth,ratio);
+        str_tree packed_tree(extent,node_size,threads);
+        if (bulk_load)
+        {
+            // the .shx holds 8 bytes per record after its 100 byte header
+            std::string shxname (shapename+".shx");
+            if (boost::filesystem::exists(shxname))
+            {
+                packed_tree.reserve((boost::filesystem::file_size(shxname) - 100) / 8);
+            }
+        }
         int count=0;
         while (true) {
             
@@ -201,7 +241,14 @@ int main (int argc,char** argv)
                 shp.skip(2*content_length-4*8-4);
             }
             
-            tree.insert(offset,item_ext);
+            if (bulk_load)
+            {
+                packed_tree.insert(offset,item_ext);
+            }
+            else
+            {
+                tree.insert(offset,item_ext);
+            }
             if (verbose) {
                 clog << "record number " << record_number << " box=" << item_ext << endl;
             }
@@ -223,10 +270,18 @@ int main (int argc,char** argv)
             clog << "cannot open index file for writing file \"" 
                  << (shapename+".index") << "\"" << endl;
         } else {
-            tree.trim();
-            std::clog<<" number nodes="<<tree.count()<<std::endl;
             file.exceptions(std::ios::failbit | std::ios::badbit);
-            tree.write(file);
+            if (bulk_load)
+            {
+                std::clog<<" number nodes="<<packed_tree.build()<<std::endl;
+                packed_tree.write(file);
+            }
+            else
+            {
+                tree.trim();
+                std::clog<<" number nodes="<<tree.count()<<std::endl;
+                tree.write(file);
+            }
             file.flush();
             file.close();
         }
@@ -0,0 +1,330 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2006 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef STR_TREE_HPP
+#define STR_TREE_HPP
+// mapnik
+#include <mapnik/box2d.hpp>
+// boost
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/math/special_functions/next.hpp>
+// stl
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+using mapnik::box2d;
+
+/** Bulk loads a spatial index with sort-tile-recursive packing and
+  * writes it in the same format as quadtree<int>::write, so the shape
+  * plugin reads it unchanged. Leaves hold up to node_capacity record
+  * offsets and every node stores the bounding box of its contents.
+  *
+  * Unlike quadtree, items are kept in a flat array with single precision
+  * extents (rounded outwards, so queries never miss a record), which is
+  * 20 bytes per record, and the sorts are spread over several threads.
+  */
+class str_tree
+{
+public:
+    str_tree(box2d<double> const& extent, unsigned node_capacity, unsigned threads)
+        : extent_(extent),
+          capacity_(std::max(node_capacity, 2u)),
+          threads_(std::max(threads, 1u)) {}
+
+    void reserve(std::size_t count)
+    {
+        items_.reserve(count);
+    }
+
+    void insert(int offset, box2d<double> const& item_ext)
+    {
+        item i;
+        i.minx = round_down(item_ext.minx());
+        i.miny = round_down(item_ext.miny());
+        i.maxx = round_up(item_ext.maxx());
+        i.maxy = round_up(item_ext.maxy());
+        i.offset = offset;
+        items_.push_back(i);
+    }
+
+    /** Packs the inserted items, returns the number of nodes. */
+    std::size_t build()
+    {
+        levels_.clear();
+        if (items_.empty()) return 0;
+
+        pack(items_);
+        levels_.push_back(std::vector<node>());
+        make_parents(items_, levels_.back());
+        while (levels_.back().size() > 1)
+        {
+            std::vector<node> & children = levels_.back();
+            pack(children);
+            std::vector<node> parents;
+            make_parents(children, parents);
+            levels_.push_back(std::vector<node>());
+            levels_.back().swap(parents);
+        }
+
+        std::size_t count = 0;
+        for (std::size_t level = 0; level < levels_.size(); ++level)
+        {
+            count += levels_[level].size();
+        }
+        return count;
+    }
+
+    void write(std::ostream& out)
+    {
+        char header[16];
+        memset(header,0,16);
+        header[0]='m';
+        header[1]='a';
+        header[2]='p';
+        header[3]='n';
+        header[4]='i';
+        header[5]='k';
+        out.write(header,16);
+        if (levels_.empty())
+        {
+            node root;
+            root.ext = extent_;
+            root.first = 0;
+            root.count = 0;
+            root.bytes = record_size(0);
+            write_record(out, root, 0, 0);
+        }
+        else
+        {
+            write_node(out, levels_.size() - 1, 0);
+        }
+    }
+
+private:
+    struct item
+    {
+        float minx, miny, maxx, maxy;
+        int offset;
+    };
+
+    struct node
+    {
+        box2d<double> ext;
+        std::size_t first;
+        std::size_t count;
+        // size of the node record and of all its descendants in the index
+        std::size_t bytes;
+    };
+
+    static float round_down(double v)
+    {
+        float f = static_cast<float>(v);
+        return (f > v) ? boost::math::float_prior(f) : f;
+    }
+
+    static float round_up(double v)
+    {
+        float f = static_cast<float>(v);
+        return (f < v) ? boost::math::float_next(f) : f;
+    }
+
+    static double center_x(item const& i) { return 0.5 * (double(i.minx) + i.maxx); }
+    static double center_y(item const& i) { return 0.5 * (double(i.miny) + i.maxy); }
+    static double center_x(node const& n) { return 0.5 * (n.ext.minx() + n.ext.maxx()); }
+    static double center_y(node const& n) { return 0.5 * (n.ext.miny() + n.ext.maxy()); }
+
+    static box2d<double> extent_of(item const& i) { return box2d<double>(i.minx, i.miny, i.maxx, i.maxy); }
+    static box2d<double> extent_of(node const& n) { return n.ext; }
+    static std::size_t bytes_of(item const&) { return sizeof(int); }
+    static std::size_t bytes_of(node const& n) { return n.bytes; }
+
+    static std::size_t record_size(std::size_t ids)
+    {
+        return sizeof(box2d<double>) + 3 * sizeof(int) + ids * sizeof(int);
+    }
+
+    template <typename T>
+    struct less_x
+    {
+        bool operator() (T const& a, T const& b) const { return center_x(a) < center_x(b); }
+    };
+
+    template <typename T>
+    struct less_y
+    {
+        bool operator() (T const& a, T const& b) const { return center_y(a) < center_y(b); }
+    };
+
+    template <typename Iter, typename Compare>
+    static void sort_range(Iter first, Iter last, Compare comp)
+    {
+        std::sort(first, last, comp);
+    }
+
+    template <typename T, typename Compare>
+    static void sort_slices(std::vector<T> & v, std::size_t slice_size,
+                            std::size_t start, std::size_t stride, Compare comp)
+    {
+        for (std::size_t begin = start * slice_size; begin < v.size(); begin += stride * slice_size)
+        {
+            std::size_t end = std::min(begin + slice_size, v.size());
+            std::sort(v.begin() + begin, v.begin() + end, comp);
+        }
+    }
+
+    /** Sorts v by sorting one chunk per thread and merging the chunks. */
+    template <typename T, typename Compare>
+    void parallel_sort(std::vector<T> & v, Compare comp)
+    {
+        typedef typename std::vector<T>::iterator iterator_type;
+        std::size_t threads = threads_;
+        if (threads < 2 || v.size() < 65536)
+        {
+            std::sort(v.begin(), v.end(), comp);
+            return;
+        }
+        std::size_t chunk = (v.size() + threads - 1) / threads;
+        std::vector<iterator_type> bounds;
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            bounds.push_back(v.begin() + std::min(i * chunk, v.size()));
+        }
+        bounds.push_back(v.end());
+
+        boost::thread_group group;
+        for (std::size_t i = 0; i + 1 < bounds.size(); ++i)
+        {
+            group.create_thread(boost::bind(&str_tree::sort_range<iterator_type,Compare>,
+                                            bounds[i], bounds[i+1], comp));
+        }
+        group.join_all();
+
+        while (bounds.size() > 2)
+        {
+            std::vector<iterator_type> merged;
+            std::size_t i = 0;
+            for (; i + 2 < bounds.size(); i += 2)
+            {
+                std::inplace_merge(bounds[i], bounds[i+1], bounds[i+2], comp);
+                merged.push_back(bounds[i]);
+            }
+            for (; i < bounds.size() - 1; ++i)
+            {
+                merged.push_back(bounds[i]);
+            }
+            merged.push_back(v.end());
+            bounds.swap(merged);
+        }
+    }
+
+    /** Orders v so that every run of capacity_ elements forms a node:
+      * sorted by x into vertical slices, each slice sorted by y.
+      */
+    template <typename T>
+    void pack(std::vector<T> & v)
+    {
+        std::size_t nodes = (v.size() + capacity_ - 1) / capacity_;
+        std::size_t slices = static_cast<std::size_t>(std::ceil(std::sqrt(double(nodes))));
+        std::size_t slice_size = capacity_ * ((nodes + slices - 1) / slices);
+
+        parallel_sort(v, less_x<T>());
+
+        std::size_t threads = std::min<std::size_t>(threads_, slices);
+        if (threads < 2 || v.size() < 65536)
+        {
+            sort_slices(v, slice_size, 0, 1, less_y<T>());
+            return;
+        }
+        boost::thread_group group;
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            group.create_thread(boost::bind(&str_tree::sort_slices<T,less_y<T> >,
+                                            boost::ref(v), slice_size, i, threads, less_y<T>()));
+        }
+        group.join_all();
+    }
+
+    template <typename T>
+    void make_parents(std::vector<T> const& children, std::vector<node> & parents)
+    {
+        parents.reserve((children.size() + capacity_ - 1) / capacity_);
+        for (std::size_t first = 0; first < children.size(); first += capacity_)
+        {
+            node n;
+            n.first = first;
+            n.count = std::min<std::size_t>(capacity_, children.size() - first);
+            n.ext = extent_of(children[first]);
+            n.bytes = record_size(0);
+            for (std::size_t i = first; i < first + n.count; ++i)
+            {
+                n.ext.expand_to_include(extent_of(children[i]));
+                n.bytes += bytes_of(children[i]);
+            }
+            parents.push_back(n);
+        }
+    }
+
+    void write_record(std::ostream& out, node const& n, int shape_count, int num_subnodes) const
+    {
+        int offset = n.bytes - record_size(shape_count);
+        std::vector<char> record(record_size(shape_count));
+        memcpy(&record[0], &offset, 4);
+        memcpy(&record[4], &n.ext, sizeof(box2d<double>));
+        memcpy(&record[36], &shape_count, 4);
+        for (int i = 0; i < shape_count; ++i)
+        {
+            memcpy(&record[40 + i * sizeof(int)], &items_[n.first + i].offset, sizeof(int));
+        }
+        memcpy(&record[40 + shape_count * sizeof(int)], &num_subnodes, 4);
+        out.write(&record[0], record.size());
+    }
+
+    void write_node(std::ostream& out, std::size_t level, std::size_t index) const
+    {
+        node const& n = levels_[level][index];
+        if (level == 0)
+        {
+            write_record(out, n, n.count, 0);
+            return;
+        }
+        write_record(out, n, 0, n.count);
+        for (std::size_t i = n.first; i < n.first + n.count; ++i)
+        {
+            write_node(out, level - 1, i);
+        }
+    }
+
+    box2d<double> extent_;
+    unsigned capacity_;
+    unsigned threads_;
+    std::vector<item> items_;
+    // levels_[0] are the leaves over items_, the last level holds the root
+    std::vector<std::vector<node> > levels_;
+};
+
+#endif //STR_TREE_HPP
@@ -0,0 +1,374 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+//$Id$
+
+// Rewrites a shapefile with its records in Hilbert curve order of their
+// bounding boxes, so that features close to each other on the map are
+// also close to each other in the .shp and .dbf. Bounding box queries then
+// read a few contiguous ranges instead of seeking all over the file.
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/program_options.hpp>
+#include "quadtree.hpp"
+#include "shapefile.hpp"
+#include "shape_io.hpp"
+
+const int DEFAULT_DEPTH = 8;
+const double DEFAULT_RATIO=0.55;
+
+struct record_ref
+{
+    boost::uint32_t key;      // position on the hilbert curve
+    int number;               // record number, also selects the dbf record
+    std::streampos offset;    // of the record header in the .shp
+    int content_length;       // in 16 bit words
+    box2d<double> ext;
+};
+
+struct by_key
+{
+    bool operator() (record_ref const& a, record_ref const& b) const
+    {
+        return a.key < b.key;
+    }
+};
+
+// distance of (x,y) along a hilbert curve filling a 2^16 x 2^16 grid
+boost::uint32_t hilbert_key(boost::uint32_t x, boost::uint32_t y)
+{
+    boost::uint32_t d = 0;
+    for (boost::uint32_t s = 1 << 15; s > 0; s >>= 1)
+    {
+        boost::uint32_t rx = (x & s) > 0;
+        boost::uint32_t ry = (y & s) > 0;
+        d += s * s * ((3 * rx) ^ ry);
+        // rotate the quadrant
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+boost::uint32_t grid_coord(double v, double min, double size)
+{
+    if (size <= 0) return 0;
+    double c = (v - min) / size * 65535.0;
+    if (c < 0) return 0;
+    if (c > 65535) return 65535;
+    return static_cast<boost::uint32_t>(c);
+}
+
+void write_int32_xdr(std::ostream & out, int val)
+{
+    char b[4];
+    b[0] = (val >> 24) & 0xff;
+    b[1] = (val >> 16) & 0xff;
+    b[2] = (val >> 8) & 0xff;
+    b[3] = val & 0xff;
+    out.write(b, 4);
+}
+
+void copy_bytes(std::istream & in, std::ostream & out, std::streamsize size)
+{
+    static std::vector<char> buffer;
+    if (buffer.size() < static_cast<std::size_t>(size)) buffer.resize(size);
+    if (size == 0) return;
+    in.read(&buffer[0], size);
+    out.write(&buffer[0], size);
+}
+
+int main (int argc,char** argv) 
+{
+    using namespace mapnik;
+    namespace po = boost::program_options;
+    using std::string;
+    using std::vector;
+    using std::clog;
+    using std::endl;
+
+    bool verbose=false;
+    unsigned int depth=DEFAULT_DEPTH;
+    double ratio=DEFAULT_RATIO;
+    vector<string> files;
+
+    try
+    {
+        po::options_description desc("shapesort utility");
+        desc.add_options()
+            ("help,h", "produce usage message")
+            ("version,V","print version string")
+            ("verbose,v","verbose output")
+            ("depth,d", po::value<unsigned int>(), "max tree depth of the index\n(default 8)")   
+            ("ratio,r",po::value<double>(),"split ratio of the index (default 0.55)")
+            ("files",po::value<vector<string> >(),"input and output shape file: input.shp output.shp")
+            ;
+
+        po::positional_options_description p;
+        p.add("files",-1);
+        po::variables_map vm;        
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(p).run(), vm);
+        po::notify(vm);
+
+        if (vm.count("version"))
+        {
+            clog<<"version 0.1.0" <<std::endl;
+            return 1;
+        }
+
+        if (vm.count("help")) 
+        {
+            clog << desc << endl;
+            return 1;
+        }
+        if (vm.count("verbose"))
+        {
+            verbose = true;
+        }
+        if (vm.count("depth"))
+        {
+            depth = vm["depth"].as<unsigned int>();
+        }
+        if (vm.count("ratio"))
+        {
+            ratio = vm["ratio"].as<double>();
+        }
+        if (vm.count("files"))
+        {
+            files=vm["files"].as< vector<string> >();
+        }
+        if (files.size() != 2)
+        {
+            clog << "usage: shapesort input.shp output.shp" << endl;
+            clog << desc << endl;
+            return 1;
+        }
+    }
+    catch (...)
+    {
+        clog << "Exception of unknown type!" << endl;
+        return -1;
+    }
+
+    string input(files[0]);
+    string output(files[1]);
+    boost::algorithm::ireplace_last(input,".shp","");
+    boost::algorithm::ireplace_last(output,".shp","");
+
+    if (input == output)
+    {
+        clog << "error : output would overwrite the input" << endl;
+        return -1;
+    }
+    if (! boost::filesystem::exists (input + ".shp") ||
+        ! boost::filesystem::exists (input + ".dbf"))
+    {
+        clog << "error : " << input << ".shp or .dbf does not exist" << endl;
+        return -1;
+    }
+
+    // collect the records and their extents
+    vector<record_ref> records;
+    box2d<double> extent;
+    int file_length = 0;
+    {
+        shape_file shp (input + ".shp");
+        if (! shp.is_open())
+        {
+            clog << "error : cannot open " << input << ".shp" << endl;
+            return -1;
+        }
+        shp.seek(24);
+        file_length = shp.read_xdr_integer();
+        shp.skip(8);
+        shp.read_envelope(extent);
+
+        int pos = 50;
+        shp.seek(pos*2);
+        while (pos < file_length)
+        {
+            record_ref rec;
+            rec.offset = shp.pos();
+            rec.number = shp.read_xdr_integer();
+            rec.content_length = shp.read_xdr_integer();
+            int shape_type = shp.read_ndr_integer();
+            if (shp.is_eof()) break;
+
+            if (shape_type == shape_io::shape_null)
+            {
+                rec.ext = box2d<double>();
+            }
+            else if (shape_type == shape_io::shape_point ||
+                     shape_type == shape_io::shape_pointm ||
+                     shape_type == shape_io::shape_pointz)
+            {
+                double x = shp.read_double();
+                double y = shp.read_double();
+                rec.ext = box2d<double>(x,y,x,y);
+            }
+            else
+            {
+                shp.read_envelope(rec.ext);
+            }
+
+            if (shape_type == shape_io::shape_null)
+            {
+                // no location, keep them at the end
+                rec.key = 0xffffffff;
+            }
+            else
+            {
+                coord2d c = rec.ext.center();
+                rec.key = hilbert_key(grid_coord(c.x, extent.minx(), extent.width()),
+                                      grid_coord(c.y, extent.miny(), extent.height()));
+            }
+            records.push_back(rec);
+
+            pos += 4 + rec.content_length;
+            shp.seek(pos*2);
+        }
+    }
+    clog << "sorting " << records.size() << " shapes" << endl;
+    std::stable_sort(records.begin(), records.end(), by_key());
+
+    std::ifstream shp_in((input + ".shp").c_str(), std::ios::in | std::ios::binary);
+    std::ifstream dbf_in((input + ".dbf").c_str(), std::ios::in | std::ios::binary);
+    std::ofstream shp_out((output + ".shp").c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    std::ofstream shx_out((output + ".shx").c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    std::ofstream dbf_out((output + ".dbf").c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!shp_in || !dbf_in || !shp_out || !shx_out || !dbf_out)
+    {
+        clog << "error : cannot open files for sorting " << input << " into " << output << endl;
+        return -1;
+    }
+
+    // the .shp and .shx headers only differ in the file length
+    char header[100];
+    shp_in.read(header, 100);
+    shp_out.write(header, 100);
+    shx_out.write(header, 24);
+    write_int32_xdr(shx_out, 50 + 4 * records.size());
+    shx_out.write(header + 28, 72);
+
+    // dbf header with the record layout
+    char dbf_header[32];
+    dbf_in.read(dbf_header, 32);
+    int num_dbf_records = (dbf_header[4] & 0xff) | (dbf_header[5] & 0xff) << 8 |
+        (dbf_header[6] & 0xff) << 16 | (dbf_header[7] & 0xff) << 24;
+    int header_length = (dbf_header[8] & 0xff) | (dbf_header[9] & 0xff) << 8;
+    int record_length = (dbf_header[10] & 0xff) | (dbf_header[11] & 0xff) << 8;
+    // one row per shape, in the order of the shapes
+    boost::uint32_t num_records = records.size();
+    dbf_header[4] = num_records & 0xff;
+    dbf_header[5] = (num_records >> 8) & 0xff;
+    dbf_header[6] = (num_records >> 16) & 0xff;
+    dbf_header[7] = (num_records >> 24) & 0xff;
+    dbf_out.write(dbf_header, 32);
+    copy_bytes(dbf_in, dbf_out, header_length - 32);
+
+    quadtree<int> tree(extent,depth,ratio);
+    int pos = 50;
+    for (unsigned i = 0; i < records.size(); ++i)
+    {
+        record_ref const& rec = records[i];
+        if (verbose)
+        {
+            clog << "record " << rec.number << " -> " << i + 1 << " box=" << rec.ext << endl;
+        }
+        if (rec.key != 0xffffffff)
+        {
+            tree.insert(pos * 2, rec.ext);
+        }
+
+        write_int32_xdr(shx_out, pos);
+        write_int32_xdr(shx_out, rec.content_length);
+
+        // records are renumbered in their new order, their dbf row moves along
+        write_int32_xdr(shp_out, i + 1);
+        write_int32_xdr(shp_out, rec.content_length);
+        shp_in.seekg(rec.offset + std::streamoff(8), std::ios::beg);
+        copy_bytes(shp_in, shp_out, rec.content_length * 2);
+        pos += 4 + rec.content_length;
+
+        if (rec.number > 0 && rec.number <= num_dbf_records)
+        {
+            dbf_in.seekg(header_length + std::streamoff(rec.number - 1) * record_length, std::ios::beg);
+            copy_bytes(dbf_in, dbf_out, record_length);
+        }
+        else
+        {
+            // keep the rows aligned, with an empty one marked deleted
+            string empty(record_length, ' ');
+            empty[0] = '*';
+            dbf_out.write(empty.data(), record_length);
+        }
+    }
+    dbf_out.put(0x1a);
+
+    if (!shp_out || !shx_out || !dbf_out)
+    {
+        clog << "error : failed writing " << output << endl;
+        return -1;
+    }
+    shp_out.close();
+    shx_out.close();
+    dbf_out.close();
+
+    if (boost::filesystem::exists(input + ".prj"))
+    {
+        std::ifstream prj_in((input + ".prj").c_str(), std::ios::in | std::ios::binary);
+        std::ofstream prj_out((output + ".prj").c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+        prj_out << prj_in.rdbuf();
+    }
+
+    std::fstream file((output + ".index").c_str(),
+                      std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file)
+    {
+        clog << "cannot open index file for writing file \"" 
+             << (output + ".index") << "\"" << endl;
+        return -1;
+    }
+    tree.trim();
+    clog << " number nodes=" << tree.count() << endl;
+    file.exceptions(std::ios::failbit | std::ios::badbit);
+    tree.write(file);
+    file.flush();
+    file.close();
+
+    clog << "done!" << endl;
+    return 0;
+}